@@ -3,5 +3,5 @@ VERSION = 1.0.0
 
 EXTRA_SRC_FILES =
 EXTRA_BINARY_FILES =
-CFLAGS += -Wall
-LDLIBS += -lSDL2 -lSDL2_image -lGL
+CFLAGS += -Wall -pthread
+LDLIBS += -lSDL2 -lSDL2_image -lGL -lpthread
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "err.h"
+#include "sequence.h"
+
+bool init_cube_batch(struct cube_batch *batch, size_t count) {
+	batch->count = count;
+	batch->capacity = (count + BATCH_ALIGN - 1) / BATCH_ALIGN * BATCH_ALIGN;
+	if (batch->capacity == 0) batch->capacity = BATCH_ALIGN;
+
+	// aligned rows so the row copies can use full width vector loads and stores
+	batch->stickers = aligned_alloc(BATCH_ALIGN, batch->capacity * 9 * 6);
+	batch->scratch = aligned_alloc(BATCH_ALIGN, batch->capacity);
+	if (!batch->stickers || !batch->scratch) {
+		warn("Failed to allocate cube batch");
+		free_cube_batch(batch);
+		return false;
+	}
+
+	reset_cube_batch(batch);
+	return true;
+}
+
+void free_cube_batch(struct cube_batch *batch) {
+	free(batch->stickers);
+	free(batch->scratch);
+	batch->stickers = NULL;
+	batch->scratch = NULL;
+	batch->count = 0;
+	batch->capacity = 0;
+}
+
+static face_color *get_row(const struct cube_batch *batch, intpos sticker) {
+	return batch->stickers + (size_t) sticker * batch->capacity;
+}
+
+void reset_cube_batch(struct cube_batch *batch) {
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		memset(get_row(batch, i), i / 9, batch->capacity);
+	}
+}
+
+void cubes_to_batch(struct cube_batch *batch, const struct cube *cubes) {
+	for (size_t j = 0; j < batch->count; ++j) {
+		for (intpos i = 0; i < 9 * 6; ++i) {
+			get_row(batch, i)[j] = cubes[j].stickers[i];
+		}
+	}
+}
+
+void batch_to_cubes(const struct cube_batch *batch, struct cube *cubes) {
+	for (size_t j = 0; j < batch->count; ++j) {
+		get_batch_cube(batch, j, &cubes[j]);
+	}
+}
+
+void get_batch_cube(const struct cube_batch *batch, size_t index, struct cube *cube) {
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		cube->stickers[i] = get_row(batch, i)[index];
+	}
+}
+
+// copies a whole row, every byte is the same sticker of a different cube
+static void copy_row(face_color *restrict dest, const face_color *restrict src, size_t capacity) {
+	// capacity is a multiple of BATCH_ALIGN and both rows are aligned
+	dest = __builtin_assume_aligned(dest, BATCH_ALIGN);
+	src = __builtin_assume_aligned(src, BATCH_ALIGN);
+	for (size_t j = 0; j < capacity; ++j) dest[j] = src[j];
+}
+
+void batch_apply_permutation(struct cube_batch *batch, const struct permutation *permutation) {
+	// move rows around each cycle of the permutation, rows that stay in place are not touched
+	uint64_t visited = 0;
+	for (intpos start = 0; start < 9 * 6; ++start) {
+		if (visited & (1ull << start)) continue;
+		visited |= 1ull << start;
+		if (permutation->stickers[start] == start) continue;
+
+		copy_row(batch->scratch, get_row(batch, start), batch->capacity);
+		intpos i = start;
+		for (;;) {
+			intpos source = permutation->stickers[i];
+			if (source == start) {
+				copy_row(get_row(batch, i), batch->scratch, batch->capacity);
+				break;
+			}
+			copy_row(get_row(batch, i), get_row(batch, source), batch->capacity);
+			visited |= 1ull << source;
+			i = source;
+		}
+	}
+}
+
+void batch_make_moves(struct cube_batch *batch, const struct move *moves, size_t count) {
+	// the moves are shared by every cube, so combine them first and touch the cubes once
+	struct compiled_moves compiled;
+	compile_moves(&compiled, moves, count);
+	batch_apply_permutation(batch, &compiled.permutation);
+}
@@ -0,0 +1,25 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include <stddef.h>
+#include "rubik.h"
+
+// many cubes stored sticker major (structure of arrays)
+// sticker i of cube j is at stickers[i * capacity + j], so every row is the same sticker of every cube
+struct cube_batch {
+	size_t count;    // number of cubes
+	size_t capacity; // length of each row, count rounded up to a multiple of BATCH_ALIGN
+	face_color *stickers;
+	face_color *scratch; // one row, used while moving rows around a cycle
+};
+
+#define BATCH_ALIGN 64
+
+bool init_cube_batch(struct cube_batch *batch, size_t count);
+void free_cube_batch(struct cube_batch *batch);
+void reset_cube_batch(struct cube_batch *batch);
+void cubes_to_batch(struct cube_batch *batch, const struct cube *cubes);
+void batch_to_cubes(const struct cube_batch *batch, struct cube *cubes);
+void get_batch_cube(const struct cube_batch *batch, size_t index, struct cube *cube);
+void batch_apply_permutation(struct cube_batch *batch, const struct permutation *permutation);
+void batch_make_moves(struct cube_batch *batch, const struct move *moves, size_t count);
+#endif //BATCH_H
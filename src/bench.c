@@ -0,0 +1,530 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "err.h"
+#include "batch.h"
+#include "coord.h"
+#include "cubie.h"
+#include "hash.h"
+#include "moves.h"
+#include "notation.h"
+#include "pack.h"
+#include "rubik.h"
+#include "simd.h"
+#include "solver.h"
+#include "symmetry.h"
+#include "transposition.h"
+#include "util.h"
+
+#define BENCH_MOVES 4096
+#define BENCH_TIME_NS 500000000ull
+#define BENCH_BATCH_CUBES 65536
+#define BENCH_BATCH_MOVES 256
+#define BENCH_SOLVES 16
+#define BENCH_SOLVE_LENGTH 20
+#define BENCH_TRANSPOSITION_MB 64
+#define BENCH_TRANSPOSITION_OPS (1 << 20)
+// moves queued before the queue is emptied again
+#define BENCH_QUEUE_LENGTH 32
+
+static struct move bench_moves[BENCH_MOVES];
+// every state along the benchmark moves
+static struct cube bench_states[BENCH_MOVES];
+
+static void print_result(const char *name, size_t count, uint64_t time_ns) {
+	double seconds = time_ns / 1e9;
+	printf("%-30s %10.2f Mmoves/s\n", name, count / seconds / 1e6);
+}
+
+static bool bench_make_move(struct cube *result, size_t *passes) {
+	struct cube cube;
+	reset_cube(&cube);
+
+	uint64_t start = get_time_ns(), elapsed;
+	*passes = 0;
+	do {
+		for (size_t i = 0; i < BENCH_MOVES; ++i) {
+			make_move(&cube, bench_moves[i], NULL);
+		}
+		++*passes;
+	} while ((elapsed = get_time_ns() - start) < BENCH_TIME_NS);
+
+	print_result("make_move", *passes * BENCH_MOVES, elapsed);
+	*result = cube;
+	return true;
+}
+
+static bool bench_simd(enum simd_level level, const struct cube *expected, size_t passes) {
+	if (!set_simd_level(level)) return true;
+
+	struct cube cube;
+	reset_cube(&cube);
+
+	uint64_t start = get_time_ns();
+	for (size_t pass = 0; pass < passes; ++pass) {
+		make_moves_simd(&cube, bench_moves, BENCH_MOVES);
+	}
+	uint64_t elapsed = get_time_ns() - start;
+
+	char name[64];
+	snprintf(name, sizeof(name), "make_moves_simd (%s)", get_simd_level_name(level));
+	print_result(name, passes * BENCH_MOVES, elapsed);
+
+	if (memcmp(&cube, expected, sizeof(cube)) != 0) {
+		warnx("%s result does not match make_move", get_simd_level_name(level));
+		return false;
+	}
+	return true;
+}
+
+static bool bench_cubie() {
+	init_cubie_moves();
+
+	// cubie cubes only support the outer face moves
+	int move_indices[BENCH_MOVES];
+	size_t count = 0;
+	struct cube expected;
+	reset_cube(&expected);
+	for (size_t i = 0; i < BENCH_MOVES; ++i) {
+		int index = get_move_index(bench_moves[i]);
+		if (index >= CUBIE_MOVE_COUNT) continue;
+		move_indices[count++] = index;
+		make_move(&expected, bench_moves[i], NULL);
+	}
+
+	struct cubie_cube cubie;
+	reset_cubie(&cubie);
+	uint64_t start = get_time_ns(), elapsed;
+	size_t passes = 0;
+	do {
+		for (size_t i = 0; i < count; ++i) cubie_make_move_index(&cubie, move_indices[i]);
+		++passes;
+	} while ((elapsed = get_time_ns() - start) < BENCH_TIME_NS);
+	print_result("cubie_make_move", passes * count, elapsed);
+
+	// check one pass against the sticker model
+	struct cube cube;
+	reset_cubie(&cubie);
+	for (size_t i = 0; i < count; ++i) cubie_make_move_index(&cubie, move_indices[i]);
+	cubie_to_cube(&cubie, &cube);
+	if (memcmp(&cube, &expected, sizeof(cube)) != 0) {
+		warnx("cubie result does not match make_move");
+		return false;
+	}
+	return true;
+}
+
+static bool check_batch(const struct cube_batch *batch, const struct move *moves, size_t count) {
+	struct cube expected, cube;
+	reset_cube(&expected);
+	for (size_t i = 0; i < count; ++i) make_move(&expected, moves[i], NULL);
+
+	get_batch_cube(batch, 0, &cube);
+	if (memcmp(&cube, &expected, sizeof(cube)) != 0) goto mismatch;
+	get_batch_cube(batch, batch->count - 1, &cube);
+	if (memcmp(&cube, &expected, sizeof(cube)) != 0) goto mismatch;
+	return true;
+mismatch:
+	warnx("batch result does not match make_move");
+	return false;
+}
+
+static bool bench_batch() {
+	struct cube_batch batch;
+	if (!init_cube_batch(&batch, BENCH_BATCH_CUBES)) return false;
+	bool ok = true;
+
+	// one move at a time
+	uint64_t start = get_time_ns();
+	for (size_t i = 0; i < BENCH_BATCH_MOVES; ++i) {
+		batch_make_moves(&batch, &bench_moves[i], 1);
+	}
+	print_result("batch_make_moves (1 move)", (size_t) BENCH_BATCH_MOVES * BENCH_BATCH_CUBES, get_time_ns() - start);
+	if (!check_batch(&batch, bench_moves, BENCH_BATCH_MOVES)) ok = false;
+
+	// whole sequence at once
+	reset_cube_batch(&batch);
+	start = get_time_ns();
+	batch_make_moves(&batch, bench_moves, BENCH_MOVES);
+	// the moves are composed into one permutation first, so count the cubes it is applied to
+	uint64_t elapsed = get_time_ns() - start;
+	printf("%-30s %10.2f Mcubes/s\n", "batch_make_moves (4096 moves)", BENCH_BATCH_CUBES / (elapsed / 1e9) / 1e6);
+	if (!check_batch(&batch, bench_moves, BENCH_MOVES)) ok = false;
+
+	free_cube_batch(&batch);
+	return ok;
+}
+
+static bool bench_symmetry() {
+	init_symmetry();
+	const struct cube *states = bench_states;
+
+	struct cube canonical;
+	uint64_t start = get_time_ns(), elapsed;
+	size_t passes = 0;
+	do {
+		for (size_t i = 0; i < BENCH_MOVES; ++i) get_canonical_cube(&states[i], &canonical);
+		++passes;
+	} while ((elapsed = get_time_ns() - start) < BENCH_TIME_NS);
+	printf("%-30s %10.2f Mcubes/s\n", "get_canonical_cube", passes * BENCH_MOVES / (elapsed / 1e9) / 1e6);
+
+	// every symmetric copy of a state has the same canonical form
+	for (size_t i = 0; i < BENCH_MOVES; i += 64) {
+		struct cube symmetric, other;
+		get_canonical_cube(&states[i], &canonical);
+		apply_symmetry(&states[i], i % SYMMETRY_COUNT, &symmetric);
+		get_canonical_cube(&symmetric, &other);
+		if (memcmp(&canonical, &other, sizeof(struct cube)) != 0) {
+			warnx("canonical cube depends on the symmetry");
+			return false;
+		}
+	}
+
+	// every corner permutation comes back from its class representative, and its symmetric copies share its class
+	for (uint16_t corners = 0; corners < CORNERS_COUNT; ++corners) {
+		int symmetry;
+		uint16_t corners_class = get_corners_class(corners, &symmetry);
+		uint16_t representative = get_corners_representative(corners_class);
+		if (corners_class >= CORNERS_CLASS_COUNT || get_corners_class(representative, NULL) != corners_class ||
+		    get_symmetric_corners(representative, symmetry) != corners ||
+		    get_corners_class(get_symmetric_corners(corners, corners % SYMMETRY_COUNT), NULL) != corners_class) {
+			warnx("corner permutation %d does not round trip through its class", corners);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool bench_hash(const struct cube *expected, size_t passes) {
+	init_cube_hash();
+
+	struct cube_hash hash = {0, 0};
+	uint64_t start = get_time_ns(), elapsed;
+	size_t hash_passes = 0;
+	do {
+		for (size_t i = 0; i < BENCH_MOVES; ++i) {
+			struct cube_hash state_hash = hash_cube(&bench_states[i]);
+			hash.low ^= state_hash.low;
+		}
+		++hash_passes;
+	} while ((elapsed = get_time_ns() - start) < BENCH_TIME_NS);
+	printf("%-30s %10.2f Mcubes/s\n", "hash_cube", hash_passes * BENCH_MOVES / (elapsed / 1e9) / 1e6);
+
+	struct cube cube;
+	reset_cube(&cube);
+	hash = hash_cube(&cube);
+	start = get_time_ns();
+	for (size_t pass = 0; pass < passes; ++pass) {
+		for (size_t i = 0; i < BENCH_MOVES; ++i) make_move_hashed(&cube, &hash, bench_moves[i]);
+	}
+	print_result("make_move_hashed", passes * BENCH_MOVES, get_time_ns() - start);
+
+	if (memcmp(&cube, expected, sizeof(cube)) != 0 || !is_same_hash(hash, hash_cube(&cube))) {
+		warnx("make_move_hashed result does not match make_move and hash_cube");
+		return false;
+	}
+	return true;
+}
+
+struct transposition_bench {
+	struct transposition_table *table;
+	int thread;
+	bool probe;
+	uint64_t hits;
+};
+
+static void *transposition_thread(void *data) {
+	// walks along its own sequence of states, storing or probing each one
+	struct transposition_bench *bench = data;
+	struct cube cube = bench_states[bench->thread * 97 % BENCH_MOVES];
+	struct cube_hash hash = hash_cube(&cube);
+	uint32_t value;
+	uint8_t depth;
+	for (uint32_t i = 0; i < BENCH_TRANSPOSITION_OPS; ++i) {
+		make_move_hashed(&cube, &hash, bench_moves[(i * 7 + bench->thread) % BENCH_MOVES]);
+		if (bench->probe) {
+			bench->hits += probe_transposition(bench->table, hash, &value, &depth);
+		} else {
+			store_transposition(bench->table, hash, i, i % 20);
+		}
+	}
+	return NULL;
+}
+
+static bool run_transposition_threads(struct transposition_table *table, int thread_count, bool probe, uint64_t *hits) {
+	struct transposition_bench benches[thread_count];
+	pthread_t threads[thread_count];
+	uint64_t start = get_time_ns();
+	int started = 0;
+	for (; started < thread_count; ++started) {
+		benches[started] = (struct transposition_bench){.table = table, .thread = started, .probe = probe, .hits = 0};
+		if (pthread_create(&threads[started], NULL, transposition_thread, &benches[started]) != 0) {
+			warnx("Failed to start benchmark thread");
+			break;
+		}
+	}
+	*hits = 0;
+	for (int i = 0; i < started; ++i) {
+		pthread_join(threads[i], NULL);
+		*hits += benches[i].hits;
+	}
+	uint64_t elapsed = get_time_ns() - start;
+
+	char name[64];
+	snprintf(name, sizeof(name), "%s_transposition (%d thread%s)", probe ? "probe" : "store", started, started == 1 ? "" : "s");
+	printf("%-30s %10.2f Mops/s\n", name, (double) started * BENCH_TRANSPOSITION_OPS / (elapsed / 1e9) / 1e6);
+	return started == thread_count;
+}
+
+static bool bench_transposition(enum replacement_policy policy) {
+	struct transposition_table table;
+	if (!init_transposition_table(&table, BENCH_TRANSPOSITION_MB, policy)) return false;
+	bool ok = true;
+
+	// every stored state has to be found again with the value stored last for it
+	for (uint32_t i = 0; i < BENCH_MOVES; ++i) store_transposition(&table, hash_cube(&bench_states[i]), i, 0);
+	for (uint32_t i = 0; i < BENCH_MOVES; ++i) {
+		struct cube_hash hash = hash_cube(&bench_states[i]);
+		uint32_t value;
+		uint8_t depth;
+		if (!probe_transposition(&table, hash, &value, &depth) || value >= BENCH_MOVES || !is_same_hash(hash_cube(&bench_states[value]), hash)) {
+			warnx("transposition table lost a state");
+			ok = false;
+			break;
+		}
+	}
+
+	clear_transposition_table(&table);
+	int threads = get_cpu_count();
+	uint64_t hits;
+	if (!run_transposition_threads(&table, threads, false, &hits)) ok = false;
+	if (!run_transposition_threads(&table, threads, true, &hits)) ok = false;
+	printf("%-30s %10.2f %%\n", "  hit rate", 100.0 * hits / ((double) threads * BENCH_TRANSPOSITION_OPS));
+
+	free_transposition_table(&table);
+	return ok;
+}
+
+static bool bench_pack_round_trip(const char *name, const struct cube *cubes, bool wide) {
+	static struct packed_cube packed[BENCH_MOVES];
+	static struct wide_packed_cube wide_packed[BENCH_MOVES];
+	static struct cube unpacked[BENCH_MOVES];
+
+	uint64_t pack_ns = 0, unpack_ns = 0;
+	size_t passes = 0;
+	enum cubie_error error = CUBIE_OK;
+	do {
+		uint64_t start = get_time_ns();
+		error = wide ? pack_cubes_wide(cubes, wide_packed, BENCH_MOVES, NULL) : pack_cubes(cubes, packed, BENCH_MOVES, NULL);
+		uint64_t middle = get_time_ns();
+		if (error == CUBIE_OK) error = wide ? unpack_cubes_wide(wide_packed, unpacked, BENCH_MOVES, NULL) : unpack_cubes(packed, unpacked, BENCH_MOVES, NULL);
+		pack_ns += middle - start;
+		unpack_ns += get_time_ns() - middle;
+		++passes;
+	} while (error == CUBIE_OK && pack_ns + unpack_ns < BENCH_TIME_NS);
+	if (error != CUBIE_OK) {
+		warnx("%s failed: %s", name, get_cubie_error_string(error));
+		return false;
+	}
+
+	char label[64];
+	snprintf(label, sizeof(label), "pack%s", name);
+	printf("%-30s %10.2f Mcubes/s\n", label, passes * BENCH_MOVES / (pack_ns / 1e9) / 1e6);
+	snprintf(label, sizeof(label), "unpack%s", name);
+	printf("%-30s %10.2f Mcubes/s\n", label, passes * BENCH_MOVES / (unpack_ns / 1e9) / 1e6);
+	snprintf(label, sizeof(label), "  round trip");
+	printf("%-30s %10.2f Mcubes/s\n", label, passes * BENCH_MOVES / ((pack_ns + unpack_ns) / 1e9) / 1e6);
+
+	if (memcmp(unpacked, cubes, sizeof(unpacked)) != 0) {
+		warnx("pack%s round trip does not give back the same cubes", name);
+		return false;
+	}
+	return true;
+}
+
+static bool bench_pack() {
+	// packing only keeps what a cubie cube has, so compare against cubes with the centers back in place
+	static struct cube cubes[BENCH_MOVES];
+	for (size_t i = 0; i < BENCH_MOVES; ++i) {
+		struct cubie_cube cubie;
+		if (cube_to_cubie(&bench_states[i], &cubie) != CUBIE_OK) {
+			warnx("benchmark state is not a valid cube");
+			return false;
+		}
+		cubie_to_cube(&cubie, &cubes[i]);
+	}
+
+	bool ok = true;
+	if (!bench_pack_round_trip("_cubes", cubes, false)) ok = false;
+	if (!bench_pack_round_trip("_cubes_wide", cubes, true)) ok = false;
+
+	// a turned cube packs the same as the cube with its centers back in place
+	for (size_t i = 0; i < BENCH_MOVES; ++i) {
+		struct packed_cube a, b;
+		if (pack_cube(&bench_states[i], &a) != CUBIE_OK || pack_cube(&cubes[i], &b) != CUBIE_OK || memcmp(&a, &b, sizeof(a)) != 0) {
+			warnx("pack_cube depends on the rotation of the cube");
+			return false;
+		}
+	}
+	return ok;
+}
+
+static bool bench_notation() {
+	// every move takes at most 3 characters with its space
+	static char text[BENCH_MOVES * 3 + 1];
+	static struct move parsed[BENCH_MOVES];
+
+	uint64_t start = get_time_ns(), elapsed;
+	size_t passes = 0, length = 0;
+	do {
+		length = format_moves(bench_moves, BENCH_MOVES, text, sizeof(text));
+		++passes;
+	} while ((elapsed = get_time_ns() - start) < BENCH_TIME_NS);
+	printf("%-30s %10.2f MB/s %10.2f Mmoves/s\n", "format_moves", passes * length / (elapsed / 1e9) / 1e6, passes * BENCH_MOVES / (elapsed / 1e9) / 1e6);
+
+	size_t count = 0, consumed, error;
+	start = get_time_ns();
+	passes = 0;
+	do {
+		count = parse_moves_chunk(text, length, true, parsed, BENCH_MOVES, &consumed, &error);
+		++passes;
+	} while ((elapsed = get_time_ns() - start) < BENCH_TIME_NS);
+	printf("%-30s %10.2f MB/s %10.2f Mmoves/s\n", "parse_moves_chunk", passes * length / (elapsed / 1e9) / 1e6, passes * count / (elapsed / 1e9) / 1e6);
+
+	if (count != BENCH_MOVES || consumed != length || error != NOTATION_NO_ERROR || memcmp(parsed, bench_moves, sizeof(parsed)) != 0) {
+		warnx("parse_moves_chunk does not give back the formatted moves");
+		return false;
+	}
+	return true;
+}
+
+static bool bench_queue() {
+	// queue_move merges and cancels moves, the queue has to leave the cube the same as playing every move
+	if (!init_moves()) return false;
+	bool ok = true;
+	size_t kept = 0, passes = 0;
+	uint64_t start = get_time_ns(), elapsed;
+	do {
+		for (size_t i = 0; i < BENCH_MOVES && ok; i += BENCH_QUEUE_LENGTH) {
+			// start from the state before these moves
+			struct cube cube;
+			if (i) cube = bench_states[i - 1];
+			else reset_cube(&cube);
+			for (size_t j = i; j < i + BENCH_QUEUE_LENGTH; ++j) {
+				if (send_move(bench_moves[j], SOURCE_SCRIPT) != SEND_OK) ok = false;
+			}
+			struct move move;
+			while (take_queued_move(&move)) {
+				make_move(&cube, move, NULL);
+				++kept;
+			}
+			if (memcmp(&cube, &bench_states[i + BENCH_QUEUE_LENGTH - 1], sizeof(struct cube)) != 0) {
+				warnx("queue_move changed what the moves do");
+				ok = false;
+			}
+		}
+		++passes;
+	} while (ok && (elapsed = get_time_ns() - start) < BENCH_TIME_NS);
+	free_moves();
+	if (!ok) return false;
+
+	print_result("send_move", passes * BENCH_MOVES, elapsed);
+	printf("%-30s %10.2f %%\n", "  moves kept", 100.0 * kept / ((double) passes * BENCH_MOVES));
+	return true;
+}
+
+static bool bench_solver_threads(const struct cubie_cube *cubes, int threads, double *rate) {
+	struct solve_options options = get_default_solve_options();
+	options.target_length = BENCH_SOLVE_LENGTH;
+	options.time_limit_ns = 0;
+	options.threads = threads;
+
+	uint64_t nodes = 0, start = get_time_ns();
+	for (size_t i = 0; i < BENCH_SOLVES; ++i) {
+		struct solution solution;
+		if (solve_cubie(&cubes[i], &options, &solution) != CUBIE_OK) return false;
+		nodes += solution.nodes;
+
+		struct cubie_cube cube = cubes[i];
+		for (size_t j = 0; j < solution.length; ++j) cubie_make_move(&cube, solution.moves[j]);
+		if (!is_cubie_solved(&cube) || (int) solution.length > BENCH_SOLVE_LENGTH) {
+			warnx("solver with %d threads returned a wrong solution", threads);
+			return false;
+		}
+	}
+	uint64_t elapsed = get_time_ns() - start;
+
+	*rate = BENCH_SOLVES / (elapsed / 1e9);
+	char name[64];
+	snprintf(name, sizeof(name), "solve_cubie (%d thread%s)", threads, threads == 1 ? "" : "s");
+	printf("%-30s %10.2f solves/s %10.2f Mnodes/s\n", name, *rate, nodes / (elapsed / 1e9) / 1e6);
+	return true;
+}
+
+static bool bench_solver() {
+	init_solver();
+
+	// random states of a fixed seed, solved to a length that takes more than one phase 1 depth
+	struct cubie_cube cubes[BENCH_SOLVES];
+	for (size_t i = 0; i < BENCH_SOLVES; ++i) {
+		reset_cubie(&cubes[i]);
+		for (size_t j = 0; j < 40; ++j) cubie_make_move_index(&cubes[i], rand() % CUBIE_MOVE_COUNT);
+	}
+
+	// doubling thread counts up to the number of cpus
+	int cpus = get_cpu_count();
+	double single = 0, rate;
+	for (int threads = 1;; threads *= 2) {
+		if (threads > cpus) threads = cpus;
+		if (!bench_solver_threads(cubes, threads, &rate)) return false;
+		if (threads == 1) single = rate;
+		else printf("%-30s %10.2fx\n", "  speedup", rate / single);
+		if (threads == cpus) break;
+	}
+	return true;
+}
+
+bool run_benchmark(enum replacement_policy policy) {
+	init_move_tables();
+	init_simd();
+	enum simd_level best_level = get_simd_level();
+
+	// same moves every run so results are comparable
+	srand(1);
+	for (size_t i = 0; i < BENCH_MOVES; ++i) {
+		bench_moves[i].face = move_faces[rand() % MOVE_FACE_COUNT];
+		bench_moves[i].dir = rand() % 3;
+	}
+
+	struct cube cube;
+	reset_cube(&cube);
+	for (size_t i = 0; i < BENCH_MOVES; ++i) {
+		make_move(&cube, bench_moves[i], NULL);
+		bench_states[i] = cube;
+	}
+
+	struct cube expected;
+	size_t passes;
+	if (!bench_make_move(&expected, &passes)) return false;
+
+	bool ok = true;
+	for (enum simd_level level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; ++level) {
+		if (!bench_simd(level, &expected, passes)) ok = false;
+	}
+
+	set_simd_level(best_level);
+
+	if (!bench_batch()) ok = false;
+	if (!bench_cubie()) ok = false;
+	if (!bench_symmetry()) ok = false;
+	if (!bench_hash(&expected, passes)) ok = false;
+	if (!bench_pack()) ok = false;
+	if (!bench_notation()) ok = false;
+	if (!bench_queue()) ok = false;
+	if (!bench_transposition(policy)) ok = false;
+	if (!bench_solver()) ok = false;
+
+	return ok;
+}
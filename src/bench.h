@@ -0,0 +1,6 @@
+#ifndef BENCH_H
+#define BENCH_H
+#include <stdbool.h>
+#include "transposition.h"
+bool run_benchmark(enum replacement_policy policy);
+#endif //BENCH_H
@@ -0,0 +1,256 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bfs.h"
+#include "coord.h"
+#include "cubie.h"
+#include "err.h"
+#include "util.h"
+
+// states are 2 bits each, 32 to a word
+#define STATES_PER_WORD 32
+// words scanned by a thread before it takes the next chunk
+#define CHUNK_WORDS 4096
+
+// states that are not found yet, the two frontiers take turns being 1 and 2, and expanded states become 0
+#define STATE_DONE 0
+#define STATE_UNSEEN 3
+
+static const char *const pieces_names[PIECES_COUNT] = {
+        [PIECES_ALL] = "all",
+        [PIECES_CORNERS] = "corners",
+        [PIECES_EDGES] = "edges",
+};
+
+// the positions the moves can change, and how the pieces in them are numbered
+struct piece_index {
+	intpos count;
+	intpos positions[12]; // the position of each slot
+	intpos slots[12];     // the slot of each position, positions that never change have none
+	intpos orientations;  // 3 for corners or 2 for edges, 1 if no move changes them
+	uint64_t permutation_count;
+	uint64_t orientation_count;
+	// for each move, the slot each slot takes its piece from and how much the piece is turned, like multiply_cubie
+	intpos sources[CUBIE_MOVE_COUNT][12];
+	intpos turns[CUBIE_MOVE_COUNT][12];
+};
+
+// the pieces of one part of a state by slot instead of by position
+struct part_state {
+	uint8_t pieces[12];
+	uint8_t orientations[12];
+};
+
+struct bfs {
+	int move_count;
+	struct piece_index corners, edges;
+	uint64_t edge_states; // states of the edge part, the corner part is the higher digit
+	uint64_t size;
+
+	_Atomic uint64_t *words;
+	size_t word_count;
+	atomic_size_t next_chunk;
+	uint8_t current, next; // values of the frontier being expanded and the one being found
+	atomic_uint_fast64_t found;
+};
+
+bool parse_bfs_pieces(const char *text, enum bfs_pieces *pieces) {
+	for (enum bfs_pieces i = 0; i < PIECES_COUNT; ++i) {
+		if (strcmp(text, pieces_names[i]) == 0) {
+			*pieces = i;
+			return true;
+		}
+	}
+	warnx("Invalid pieces: %s, expected all, corners or edges", text);
+	return false;
+}
+
+static void init_piece_index(struct piece_index *index, const int *moves, int move_count, bool corners, bool used) {
+	// a position is part of the state if some move takes its piece away or turns it
+	intpos total = corners ? 8 : 12;
+	bool oriented = false;
+	index->count = 0;
+	for (intpos i = 0; i < total; ++i) {
+		index->slots[i] = 0xff;
+		bool moved = false;
+		for (int j = 0; j < move_count && used; ++j) {
+			const struct cubie_cube *move = get_cubie_move(moves[j]);
+			uint8_t piece = corners ? move->corners[i] : move->edges[i];
+			if (piece != (corners ? MAKE_CORNER(i, 0) : MAKE_EDGE(i, 0))) moved = true;
+			if (corners ? CORNER_ORIENTATION(piece) : EDGE_ORIENTATION(piece)) oriented = true;
+		}
+		if (!moved) continue;
+		index->slots[i] = index->count;
+		index->positions[index->count++] = i;
+	}
+
+	// the moves never take a piece out of the positions that are part of the state
+	for (int j = 0; j < move_count; ++j) {
+		const struct cubie_cube *move = get_cubie_move(moves[j]);
+		for (intpos k = 0; k < index->count; ++k) {
+			uint8_t piece = corners ? move->corners[index->positions[k]] : move->edges[index->positions[k]];
+			index->sources[j][k] = index->slots[corners ? CORNER_PIECE(piece) : EDGE_PIECE(piece)];
+			index->turns[j][k] = corners ? CORNER_ORIENTATION(piece) : EDGE_ORIENTATION(piece);
+		}
+	}
+
+	// the pieces that never move keep their orientation, so the last moved one follows from the others
+	index->orientations = oriented ? (corners ? 3 : 2) : 1;
+	index->permutation_count = 1;
+	index->orientation_count = 1;
+	for (intpos i = 1; i <= index->count; ++i) index->permutation_count *= i;
+	for (intpos i = 1; i < index->count; ++i) index->orientation_count *= index->orientations;
+}
+
+static uint64_t get_part_index(const struct piece_index *index, const struct part_state *part) {
+	uint64_t orientation = 0;
+	for (intpos i = 0; i + 1 < index->count; ++i) orientation = orientation * index->orientations + part->orientations[i];
+	return get_permutation_rank(part->pieces, index->count) * index->orientation_count + orientation;
+}
+
+static void set_part_index(const struct piece_index *index, struct part_state *part, uint64_t value) {
+	uint64_t orientation = value % index->orientation_count;
+	set_permutation_rank(part->pieces, index->count, value / index->orientation_count);
+	if (!index->count) return;
+
+	intpos sum = 0;
+	for (intpos i = index->count - 1; i-- > 0;) {
+		part->orientations[i] = orientation % index->orientations;
+		orientation /= index->orientations;
+		sum += part->orientations[i];
+	}
+	part->orientations[index->count - 1] = (index->orientations - sum % index->orientations) % index->orientations;
+}
+
+static void move_part(const struct piece_index *index, int move, const struct part_state *part, struct part_state *result) {
+	const intpos *sources = index->sources[move], *turns = index->turns[move];
+	for (intpos i = 0; i < index->count; ++i) {
+		intpos orientation = part->orientations[sources[i]] + turns[i];
+		result->pieces[i] = part->pieces[sources[i]];
+		result->orientations[i] = orientation >= index->orientations ? orientation - index->orientations : orientation;
+	}
+}
+
+static bool find_state(struct bfs *bfs, uint64_t state) {
+	// only unseen states change, and every thread gives them the same value, so clearing bits is enough
+	_Atomic uint64_t *word = &bfs->words[state / STATES_PER_WORD];
+	int shift = state % STATES_PER_WORD * 2;
+	if ((atomic_load_explicit(word, memory_order_relaxed) >> shift & 3) != STATE_UNSEEN) return false;
+	uint64_t old = atomic_fetch_and_explicit(word, ~((uint64_t) (STATE_UNSEEN ^ bfs->next) << shift), memory_order_relaxed);
+	return (old >> shift & 3) == STATE_UNSEEN;
+}
+
+static void *bfs_thread(void *data) {
+	struct bfs *bfs = data;
+	// every 2 bits that equal the frontier are 0 after xoring with this
+	uint64_t pattern = 0x5555555555555555ull * bfs->current;
+	uint64_t found = 0;
+	for (;;) {
+		size_t first = atomic_fetch_add(&bfs->next_chunk, CHUNK_WORDS);
+		if (first >= bfs->word_count) break;
+		size_t last = first + CHUNK_WORDS < bfs->word_count ? first + CHUNK_WORDS : bfs->word_count;
+		for (size_t i = first; i < last; ++i) {
+			uint64_t difference = atomic_load_explicit(&bfs->words[i], memory_order_relaxed) ^ pattern;
+			uint64_t frontier = ~(difference | difference >> 1) & 0x5555555555555555ull;
+			if (!frontier) continue;
+
+			for (uint64_t bits = frontier; bits; bits &= bits - 1) {
+				uint64_t state = i * STATES_PER_WORD + __builtin_ctzll(bits) / 2;
+				struct part_state corners, edges, moved_corners, moved_edges;
+				set_part_index(&bfs->corners, &corners, state / bfs->edge_states);
+				set_part_index(&bfs->edges, &edges, state % bfs->edge_states);
+				for (int move = 0; move < bfs->move_count; ++move) {
+					move_part(&bfs->corners, move, &corners, &moved_corners);
+					move_part(&bfs->edges, move, &edges, &moved_edges);
+					uint64_t next = get_part_index(&bfs->corners, &moved_corners) * bfs->edge_states + get_part_index(&bfs->edges, &moved_edges);
+					found += find_state(bfs, next);
+				}
+			}
+			// new states never have the value of the frontier, so only the frontier is cleared
+			atomic_fetch_and_explicit(&bfs->words[i], ~(frontier * 3), memory_order_relaxed);
+		}
+	}
+	atomic_fetch_add(&bfs->found, found);
+	return NULL;
+}
+
+static uint64_t expand_frontier(struct bfs *bfs, int thread_count) {
+	atomic_store(&bfs->next_chunk, 0);
+	atomic_store(&bfs->found, 0);
+	pthread_t threads[thread_count];
+
+	// this thread does the work of the first one
+	int started = 1;
+	for (; started < thread_count; ++started) {
+		if (pthread_create(&threads[started], NULL, bfs_thread, bfs) != 0) {
+			warnx("Failed to start search thread");
+			break;
+		}
+	}
+	bfs_thread(bfs);
+	for (int i = 1; i < started; ++i) pthread_join(threads[i], NULL);
+	return atomic_load(&bfs->found);
+}
+
+bool enumerate_subgroup(const struct bfs_options *options, struct bfs_stats *stats) {
+	init_cubie_moves();
+	*stats = (struct bfs_stats){0};
+
+	struct bfs bfs = {.move_count = 0};
+	int moves[CUBIE_MOVE_COUNT];
+	for (size_t i = 0; i < options->face_count; ++i) {
+		int index = get_move_index((struct move){.face = options->faces[i], .dir = cw});
+		if (index < 0 || index >= CUBIE_MOVE_COUNT) {
+			warnx("Only the outer face moves U, R, F, D, L and B can be enumerated, not '%c'", options->faces[i]);
+			return false;
+		}
+		for (int dir = 0; dir < 3; ++dir) moves[bfs.move_count++] = index + dir;
+	}
+
+	init_piece_index(&bfs.corners, moves, bfs.move_count, true, options->pieces != PIECES_EDGES);
+	init_piece_index(&bfs.edges, moves, bfs.move_count, false, options->pieces != PIECES_CORNERS);
+	bfs.edge_states = bfs.edges.permutation_count * bfs.edges.orientation_count;
+	// in floating point, so a product that does not fit can not overflow
+	long double size = (long double) bfs.corners.permutation_count * bfs.corners.orientation_count * bfs.edges.permutation_count * bfs.edges.orientation_count;
+	if (size > BFS_MAX_STATES) {
+		warnx("The index needs %.3Le states, at most %llu are supported, try fewer pieces or moves", size, BFS_MAX_STATES);
+		return false;
+	}
+	bfs.size = (uint64_t) size;
+	stats->index_size = bfs.size;
+
+	bfs.word_count = (bfs.size + STATES_PER_WORD - 1) / STATES_PER_WORD;
+	bfs.words = malloc(bfs.word_count * sizeof(uint64_t));
+	if (!bfs.words) {
+		warn("Failed to allocate %zu MiB for the search", bfs.word_count * sizeof(uint64_t) >> 20);
+		return false;
+	}
+	// the unused states at the end are never searched, so they can be unseen too
+	memset(bfs.words, 0xff, bfs.word_count * sizeof(uint64_t));
+
+	uint64_t start = get_time_ns();
+	// the solved cube has every piece in its own slot, which is state 0
+	bfs.next = 1;
+	find_state(&bfs, 0);
+	stats->counts[0] = stats->states = 1;
+	stats->time_ns = get_time_ns() - start;
+	if (options->on_depth) options->on_depth(0, stats, options->userdata);
+
+	int thread_count = options->threads > 0 ? options->threads : 1;
+	for (int depth = 0; depth < BFS_MAX_DEPTH; ++depth) {
+		bfs.current = bfs.next;
+		bfs.next = 3 - bfs.current;
+		uint64_t found = expand_frontier(&bfs, thread_count);
+		if (!found) break;
+
+		stats->depth = depth + 1;
+		stats->counts[depth + 1] = found;
+		stats->states += found;
+		stats->time_ns = get_time_ns() - start;
+		if (options->on_depth) options->on_depth(depth + 1, stats, options->userdata);
+	}
+
+	free(bfs.words);
+	return true;
+}
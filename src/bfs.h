@@ -0,0 +1,44 @@
+#ifndef BFS_H
+#define BFS_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "rubik.h"
+
+// breadth first search over every state some outer face moves reach, counting the states at each distance
+// every state takes 2 bits, and only the pieces the moves can reach are part of a state
+
+#define BFS_MAX_DEPTH 64
+// largest index the search takes on, it needs a quarter of this in bytes
+#define BFS_MAX_STATES (1ull << 36)
+
+// pieces that make up a state, the others are ignored
+enum bfs_pieces {
+	PIECES_ALL,
+	PIECES_CORNERS, // like a 2x2x2 cube
+	PIECES_EDGES,
+	PIECES_COUNT,
+};
+
+struct bfs_stats {
+	uint64_t index_size; // states the index has room for, including ones that can not be reached
+	uint64_t states;     // states found so far
+	uint64_t counts[BFS_MAX_DEPTH + 1];
+	int depth; // deepest distance with any states
+	uint64_t time_ns;
+};
+
+struct bfs_options {
+	enum move_face faces[MOVE_FACE_COUNT];
+	size_t face_count;
+	enum bfs_pieces pieces;
+	int threads;
+
+	// called once the number of states at a distance is known, may be NULL
+	void (*on_depth)(int depth, const struct bfs_stats *stats, void *userdata);
+	void *userdata;
+};
+
+bool parse_bfs_pieces(const char *text, enum bfs_pieces *pieces);
+bool enumerate_subgroup(const struct bfs_options *options, struct bfs_stats *stats);
+#endif //BFS_H
@@ -0,0 +1,463 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/resource.h>
+#include "cli.h"
+#include "bfs.h"
+#include "err.h"
+#include "generator.h"
+#include "notation.h"
+#include "optimal.h"
+#include "record.h"
+#include "scramble.h"
+#include "util.h"
+
+// longest scramble accepted on the command line
+#define MAX_SCRAMBLE_LENGTH 1024
+// lines read before they are solved, at most this many results are kept in memory
+#define BATCH_CHUNK_SIZE 1024
+// random states generated from each stream of the seed, so the scrambles are the same with any number of threads
+#define SCRAMBLE_CHUNK_SIZE 64
+// longest line of --scramble output, a scramble or facelets and the newline
+#define SCRAMBLE_LINE_SIZE (MAX_SOLUTION_LENGTH * 4)
+
+static bool parse_cube(const char *text, struct cube *cube) {
+	// either a facelet string or a scramble applied to a solved cube
+	if (is_facelet_string(text)) return parse_facelets(text, cube);
+
+	struct move moves[MAX_SCRAMBLE_LENGTH];
+	size_t count;
+	if (!parse_moves(text, moves, MAX_SCRAMBLE_LENGTH, &count)) return false;
+	reset_cube(cube);
+	for (size_t i = 0; i < count; ++i) make_move(cube, moves[i], NULL);
+	return true;
+}
+
+static void print_improvement(const struct solution *solution, void *userdata) {
+	// time since the solve started, the length and the solution itself
+	char text[MAX_SOLUTION_LENGTH * 4];
+	format_moves(solution->moves, solution->length, text, sizeof(text));
+	fprintf(stderr, "%10.3f ms  %2zu moves  %s\n", solution->time_ns / 1e6, solution->length, text);
+}
+
+bool run_solve(const char *scramble, const struct solve_options *options) {
+	struct cube cube;
+	if (!parse_cube(scramble, &cube)) return false;
+
+	if (options->optimal) init_optimal_solver(options);
+	else init_solver();
+	struct solve_options solve_options = *options;
+	solve_options.on_solution = print_improvement;
+	struct solution solution;
+	uint64_t start = get_time_ns();
+	enum cubie_error error = solve_cube(&cube, &solve_options, &solution);
+	uint64_t elapsed = get_time_ns() - start;
+	if (error != CUBIE_OK) {
+		warnx("Cannot solve cube: %s", get_cubie_error_string(error));
+		return false;
+	}
+
+	char text[MAX_SOLUTION_LENGTH * 4];
+	format_moves(solution.moves, solution.length, text, sizeof(text));
+	printf("%s\n", text);
+	fprintf(stderr, "%zu moves found in %.3f ms, %llu nodes in %.3f ms, %.2f Mnodes/s\n", solution.length, solution.time_ns / 1e6,
+	        (unsigned long long) solution.nodes, elapsed / 1e6, solution.nodes / (elapsed / 1e9) / 1e6);
+	return true;
+}
+
+struct batch_item {
+	size_t line;
+	struct cube cube;
+	enum cubie_error error;
+	struct solution solution;
+	bool done;
+};
+
+struct batch {
+	struct solve_options options; // used for each cube, one thread per cube
+	bool unordered;
+	struct batch_item *items;
+	size_t count;
+	atomic_size_t next; // next item a worker takes
+	size_t printed;     // items written so far in input order
+	pthread_mutex_t lock;
+	pthread_cond_t item_done;
+
+	size_t solved, failed, total_length;
+	uint64_t nodes;
+};
+
+static void print_item(struct batch *batch, const struct batch_item *item) {
+	if (item->error != CUBIE_OK) {
+		warnx("Line %zu: cannot solve cube: %s", item->line, get_cubie_error_string(item->error));
+		++batch->failed;
+		return;
+	}
+
+	// line number, solution, move count, time in milliseconds
+	char text[MAX_SOLUTION_LENGTH * 4];
+	format_moves(item->solution.moves, item->solution.length, text, sizeof(text));
+	printf("%zu\t%s\t%zu\t%.3f\n", item->line, text, item->solution.length, item->solution.time_ns / 1e6);
+	++batch->solved;
+	batch->total_length += item->solution.length;
+	batch->nodes += item->solution.nodes;
+}
+
+static void *batch_worker(void *data) {
+	struct batch *batch = data;
+	for (;;) {
+		size_t index = atomic_fetch_add(&batch->next, 1);
+		if (index >= batch->count) break;
+		struct batch_item *item = &batch->items[index];
+		item->error = solve_cube(&item->cube, &batch->options, &item->solution);
+
+		pthread_mutex_lock(&batch->lock);
+		if (batch->unordered) print_item(batch, item);
+		item->done = true;
+		pthread_cond_broadcast(&batch->item_done);
+		pthread_mutex_unlock(&batch->lock);
+	}
+	return NULL;
+}
+
+static void solve_chunk(struct batch *batch, int thread_count) {
+	atomic_store(&batch->next, 0);
+	batch->printed = 0;
+	if ((size_t) thread_count > batch->count) thread_count = batch->count;
+
+	pthread_t threads[thread_count];
+	int started = 0;
+	for (; started < thread_count; ++started) {
+		if (pthread_create(&threads[started], NULL, batch_worker, batch) != 0) {
+			warnx("Failed to start batch thread");
+			break;
+		}
+	}
+	// with no threads at all, solve everything here
+	if (started == 0) batch_worker(batch);
+
+	if (!batch->unordered) {
+		// write each result as soon as everything before it is done
+		pthread_mutex_lock(&batch->lock);
+		while (batch->printed < batch->count) {
+			while (!batch->items[batch->printed].done) pthread_cond_wait(&batch->item_done, &batch->lock);
+			print_item(batch, &batch->items[batch->printed++]);
+		}
+		pthread_mutex_unlock(&batch->lock);
+	}
+
+	for (int i = 0; i < started; ++i) pthread_join(threads[i], NULL);
+	fflush(stdout);
+}
+
+bool run_solve_batch(const char *path, const struct solve_options *options, bool unordered) {
+	// one line per cube, read from stdin without a path
+	FILE *file = stdin;
+	if (path && strcmp(path, "-") != 0) {
+		file = fopen(path, "r");
+		if (!file) {
+			warn("%s", path);
+			return false;
+		}
+	}
+
+	struct batch batch = {.options = *options, .unordered = unordered};
+	batch.options.threads = 1;
+	batch.items = malloc(BATCH_CHUNK_SIZE * sizeof(struct batch_item));
+	if (!batch.items) {
+		warn("Failed to allocate batch");
+		if (file != stdin) fclose(file);
+		return false;
+	}
+	pthread_mutex_init(&batch.lock, NULL);
+	pthread_cond_init(&batch.item_done, NULL);
+	// the tables have to be ready before several threads use them
+	if (options->optimal) init_optimal_solver(options);
+	else init_solver();
+
+	uint64_t start = get_time_ns();
+	char *line = NULL;
+	size_t line_size = 0, line_number = 0, invalid = 0;
+	bool eof = false;
+	while (!eof) {
+		batch.count = 0;
+		while (batch.count < BATCH_CHUNK_SIZE) {
+			if (getline(&line, &line_size, file) < 0) {
+				eof = true;
+				break;
+			}
+			++line_number;
+
+			// trim whitespace, skip blank lines and comments
+			char *text = line, *end = line + strlen(line);
+			while (isspace((unsigned char) *text)) ++text;
+			while (end > text && isspace((unsigned char) end[-1])) --end;
+			*end = '\0';
+			if (!*text || *text == '#') continue;
+
+			struct batch_item *item = &batch.items[batch.count];
+			if (!parse_cube(text, &item->cube)) {
+				warnx("Line %zu: skipped", line_number);
+				++invalid;
+				continue;
+			}
+			item->line = line_number;
+			item->done = false;
+			++batch.count;
+		}
+		if (batch.count) solve_chunk(&batch, options->threads);
+	}
+	if (ferror(file)) warn("%s", path ? path : "stdin");
+
+	uint64_t elapsed = get_time_ns() - start;
+	fprintf(stderr, "%zu cubes solved in %.3f s, %.1f cubes/s, %.2f moves on average, %.2f Mnodes/s\n",
+	        batch.solved, elapsed / 1e9, batch.solved / (elapsed / 1e9),
+	        batch.solved ? (double) batch.total_length / batch.solved : 0.0, batch.nodes / (elapsed / 1e9) / 1e6);
+	bool ok = !ferror(file) && !invalid && !batch.failed;
+
+	free(line);
+	free(batch.items);
+	pthread_mutex_destroy(&batch.lock);
+	pthread_cond_destroy(&batch.item_done);
+	if (file != stdin) fclose(file);
+	return ok;
+}
+
+static void print_algorithm(const struct move *moves, size_t count, void *userdata) {
+	char text[GENERATOR_MAX_DEPTH * 4];
+	format_moves(moves, count, text, sizeof(text));
+	printf("%s\n", text);
+}
+
+static void print_generator_depth(int depth, const struct generator_stats *stats, void *userdata) {
+	// everything up to this length is complete, so let it through a pipe straight away
+	fflush(stdout);
+	fprintf(stderr, "Depth %d: %llu algorithms, %llu nodes in %.3f s, %.2f Mnodes/s\n", depth,
+	        (unsigned long long) stats->solutions, (unsigned long long) stats->nodes, stats->time_ns / 1e9,
+	        stats->nodes / (stats->time_ns / 1e9) / 1e6);
+}
+
+bool run_generate(const char *move_set, const char *case_text, const char *mask, int max_depth, int threads) {
+	struct generator_options options = {
+	        .mask = MASK_FULL,
+	        .max_depth = max_depth,
+	        .threads = threads,
+	        .on_solution = print_algorithm,
+	        .on_depth = print_generator_depth,
+	        .userdata = NULL,
+	};
+	if (!parse_move_set(move_set, options.faces, &options.face_count)) return false;
+	if (mask && !parse_generator_mask(mask, &options.mask)) return false;
+	// without a case, every algorithm that does nothing is found
+	if (case_text) {
+		if (!parse_cube(case_text, &options.start)) return false;
+	} else {
+		reset_cube(&options.start);
+	}
+
+	struct generator_stats stats;
+	return generate_algorithms(&options, &stats);
+}
+
+static void print_bfs_depth(int depth, const struct bfs_stats *stats, void *userdata) {
+	printf("%2d %15llu\n", depth, (unsigned long long) stats->counts[depth]);
+	fflush(stdout);
+}
+
+bool run_bfs(const char *move_set, const char *pieces, int threads) {
+	struct bfs_options options = {
+	        .pieces = PIECES_ALL,
+	        .threads = threads,
+	        .on_depth = print_bfs_depth,
+	        .userdata = NULL,
+	};
+	if (!parse_move_set(move_set, options.faces, &options.face_count)) return false;
+	if (pieces && !parse_bfs_pieces(pieces, &options.pieces)) return false;
+
+	struct bfs_stats stats;
+	if (!enumerate_subgroup(&options, &stats)) return false;
+
+	// ru_maxrss is in KiB on linux
+	struct rusage usage;
+	double peak_rss = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss / 1024.0 : 0.0;
+	fprintf(stderr, "%llu states up to depth %d of %llu in the index, %.3f s, %.2f Mstates/s, peak RSS %.1f MiB\n",
+	        (unsigned long long) stats.states, stats.depth, (unsigned long long) stats.index_size, stats.time_ns / 1e9,
+	        stats.states / (stats.time_ns / 1e9) / 1e6, peak_rss);
+	return true;
+}
+
+struct scramble_run {
+	struct solve_options options; // used for each cube, one thread per cube
+	bool facelets;
+	size_t count;
+	pthread_mutex_t lock;
+	pthread_cond_t chunk_done;
+
+	// guarded by lock
+	struct random next_stream; // stream of the next chunk
+	size_t next_chunk, written_chunks;
+	size_t failed, total_length;
+};
+
+static size_t format_scramble_chunk(struct scramble_run *run, struct random *random, size_t first, size_t last, char *text, size_t *total_length, size_t *failed) {
+	size_t used = 0;
+	for (size_t i = first; i < last; ++i) {
+		struct cubie_cube cubie;
+		get_random_cubie(random, &cubie);
+		if (run->facelets) {
+			struct cube cube;
+			cubie_to_cube(&cubie, &cube);
+			format_facelets(&cube, text + used);
+			used += 9 * 6;
+			text[used++] = '\n';
+			continue;
+		}
+
+		struct solution scramble;
+		enum cubie_error error = get_scramble(&cubie, &run->options, &scramble);
+		if (error != CUBIE_OK) {
+			warnx("Scramble %zu: cannot solve cube: %s", i + 1, get_cubie_error_string(error));
+			++*failed;
+			continue;
+		}
+		used += format_moves(scramble.moves, scramble.length, text + used, SCRAMBLE_LINE_SIZE);
+		text[used++] = '\n';
+		*total_length += scramble.length;
+	}
+	return used;
+}
+
+static void *scramble_worker(void *data) {
+	struct scramble_run *run = data;
+	char text[SCRAMBLE_CHUNK_SIZE * SCRAMBLE_LINE_SIZE];
+	for (;;) {
+		pthread_mutex_lock(&run->lock);
+		size_t chunk = run->next_chunk++;
+		struct random random = run->next_stream;
+		jump_random(&run->next_stream);
+		pthread_mutex_unlock(&run->lock);
+
+		size_t first = chunk * SCRAMBLE_CHUNK_SIZE;
+		if (first >= run->count) break;
+		size_t last = first + SCRAMBLE_CHUNK_SIZE < run->count ? first + SCRAMBLE_CHUNK_SIZE : run->count;
+		size_t total_length = 0, failed = 0;
+		size_t used = format_scramble_chunk(run, &random, first, last, text, &total_length, &failed);
+
+		// write the chunks in order, each one as soon as the one before it is written
+		pthread_mutex_lock(&run->lock);
+		while (run->written_chunks != chunk) pthread_cond_wait(&run->chunk_done, &run->lock);
+		fwrite(text, 1, used, stdout);
+		++run->written_chunks;
+		run->failed += failed;
+		run->total_length += total_length;
+		pthread_cond_broadcast(&run->chunk_done);
+		pthread_mutex_unlock(&run->lock);
+	}
+	return NULL;
+}
+
+bool run_scramble(size_t count, uint64_t seed, const struct solve_options *options, bool facelets) {
+	struct scramble_run run = {.options = *options, .facelets = facelets, .count = count};
+	run.options.threads = 1;
+	// a time limit would make the scrambles depend on how fast the machine is
+	run.options.time_limit_ns = 0;
+	run.options.on_solution = NULL;
+	seed_random(&run.next_stream, seed);
+	pthread_mutex_init(&run.lock, NULL);
+	pthread_cond_init(&run.chunk_done, NULL);
+	if (!facelets) {
+		if (options->optimal) init_optimal_solver(options);
+		else init_solver();
+	}
+
+	uint64_t start = get_time_ns();
+	int thread_count = options->threads > 0 ? options->threads : 1;
+	pthread_t threads[thread_count];
+	// this thread is worker 0
+	int started = 1;
+	for (; started < thread_count; ++started) {
+		if (pthread_create(&threads[started], NULL, scramble_worker, &run) != 0) {
+			warnx("Failed to start scramble thread");
+			break;
+		}
+	}
+	scramble_worker(&run);
+	for (int i = 1; i < started; ++i) pthread_join(threads[i], NULL);
+	fflush(stdout);
+	uint64_t elapsed = get_time_ns() - start;
+
+	if (facelets) {
+		fprintf(stderr, "%zu states in %.3f s, %.1f states/s\n", count, elapsed / 1e9, count / (elapsed / 1e9));
+	} else {
+		size_t found = count - run.failed;
+		fprintf(stderr, "%zu scrambles in %.3f s, %.1f scrambles/s, %.2f moves on average\n", found, elapsed / 1e9, found / (elapsed / 1e9),
+		        found ? (double) run.total_length / found : 0.0);
+	}
+	if (ferror(stdout)) warn("stdout");
+	bool ok = !ferror(stdout) && !run.failed;
+	pthread_mutex_destroy(&run.lock);
+	pthread_cond_destroy(&run.chunk_done);
+	return ok;
+}
+
+bool run_replay(const char *path) {
+	struct replay replay;
+	if (!open_replay(path, &replay)) return false;
+
+	// read the whole log first, so replaying it only measures the moves
+	struct move *log = NULL;
+	size_t count = 0, capacity = 0, sources[SOURCE_COUNT] = {0};
+	struct recorded_move move = {.time_us = 0};
+	enum replay_result result;
+	uint64_t start = get_time_ns();
+	while ((result = read_replay_move(&replay, &move)) == REPLAY_MOVE) {
+		if (count == capacity) {
+			capacity = capacity ? capacity * 2 : 1024;
+			struct move *moves = realloc(log, capacity * sizeof(struct move));
+			if (!moves) {
+				warn("Failed to allocate replay");
+				free(log);
+				close_replay(&replay);
+				return false;
+			}
+			log = moves;
+		}
+		log[count++] = move.move;
+		++sources[move.source];
+	}
+	uint64_t read_time = get_time_ns() - start;
+	close_replay(&replay);
+	if (result == REPLAY_ERROR) {
+		free(log);
+		return false;
+	}
+
+	struct cube cube = replay.start;
+	start = get_time_ns();
+	for (size_t i = 0; i < count; ++i) make_move(&cube, log[i], NULL);
+	uint64_t replay_time = get_time_ns() - start;
+	free(log);
+
+	char facelets[9 * 6 + 1];
+	format_facelets(&cube, facelets);
+	printf("%s\n", facelets);
+	fprintf(stderr, "%zu moves over %.3f s: %zu %s, %zu %s, %zu %s, %zu %s\n", count, replay.time_us / 1e6,
+	        sources[SOURCE_KEYBOARD], get_move_source_name(SOURCE_KEYBOARD), sources[SOURCE_SHUFFLE], get_move_source_name(SOURCE_SHUFFLE),
+	        sources[SOURCE_SOLUTION], get_move_source_name(SOURCE_SOLUTION), sources[SOURCE_SCRIPT], get_move_source_name(SOURCE_SCRIPT));
+	fprintf(stderr, "read in %.3f ms, %.2f Mmoves/s, replayed in %.3f ms, %.2f Mmoves/s\n", read_time / 1e6, count / (read_time / 1e9) / 1e6,
+	        replay_time / 1e6, count / (replay_time / 1e9) / 1e6);
+
+	if (!replay.finished) {
+		warnx("%s: the session was cut short, there is no final cube to check", path);
+		return true;
+	}
+	if (memcmp(&cube, &replay.end, sizeof(struct cube)) != 0) {
+		warnx("%s: the replayed cube does not match the final cube of the session", path);
+		return false;
+	}
+	fprintf(stderr, "Final cube matches\n");
+	return true;
+}
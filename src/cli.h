@@ -0,0 +1,12 @@
+#ifndef CLI_H
+#define CLI_H
+#include <stdbool.h>
+#include "solver.h"
+
+bool run_solve(const char *scramble, const struct solve_options *options);
+bool run_solve_batch(const char *path, const struct solve_options *options, bool unordered);
+bool run_generate(const char *move_set, const char *case_text, const char *mask, int max_depth, int threads);
+bool run_bfs(const char *move_set, const char *pieces, int threads);
+bool run_replay(const char *path);
+bool run_scramble(size_t count, uint64_t seed, const struct solve_options *options, bool facelets);
+#endif //CLI_H
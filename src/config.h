@@ -5,7 +5,9 @@
 
 typedef uint32_t int_time; // what type to use for time (should be the same as SDL and GL, so GLuint and Uint32)
 static const int_time turn_time = 400, turn_time_shuffle = 150;
-static const uint32_t max_moves = 4;
+// with more moves than this queued, turns get faster so the whole queue takes about as long as this many turns
+// at instant_queue_depth moves are applied without turning until the queue is shorter again
+static const uint32_t adaptive_queue_depth = 4, instant_queue_depth = 64;
 
 #ifdef RENDER
 static const float
@@ -0,0 +1,217 @@
+#include "coord.h"
+#include "err.h"
+#include "table_file.h"
+
+const uint16_t (*twist_move)[CUBIE_MOVE_COUNT];
+const uint16_t (*flip_move)[CUBIE_MOVE_COUNT];
+const uint16_t (*slice_sorted_move)[CUBIE_MOVE_COUNT];
+const uint16_t (*corners_move)[CUBIE_MOVE_COUNT];
+const uint16_t (*ud_edges_move)[CUBIE_MOVE_COUNT];
+
+// change this whenever the coordinates are defined differently
+#define COORD_TABLES_VERSION 1
+#define COORD_FILE_NAME "coord-moves.tbl"
+
+#define TWIST_MOVE_SIZE (sizeof(uint16_t) * TWIST_COUNT * CUBIE_MOVE_COUNT)
+#define FLIP_MOVE_SIZE (sizeof(uint16_t) * FLIP_COUNT * CUBIE_MOVE_COUNT)
+#define SLICE_SORTED_MOVE_SIZE (sizeof(uint16_t) * SLICE_SORTED_COUNT * CUBIE_MOVE_COUNT)
+#define CORNERS_MOVE_SIZE (sizeof(uint16_t) * CORNERS_COUNT * CUBIE_MOVE_COUNT)
+#define UD_EDGES_MOVE_SIZE (sizeof(uint16_t) * UD_EDGES_COUNT * CUBIE_MOVE_COUNT)
+
+static struct table_file coord_file;
+static uint64_t coord_tables_key = 0;
+
+uint32_t get_binomial(intpos n, intpos k) {
+	if (k > n) return 0;
+	uint32_t result = 1;
+	for (intpos i = 1; i <= k; ++i) {
+		result = result * (n - k + i) / i;
+	}
+	return result;
+}
+
+uint32_t get_permutation_rank(const uint8_t *permutation, intpos count) {
+	// lehmer code, the identity permutation is 0
+	// each digit is how many smaller values come later, smaller has 4 bits per value counting the smaller ones seen so far
+	uint32_t rank = 0;
+	uint64_t smaller = 0;
+	for (intpos i = 0; i < count; ++i) {
+		intpos value = permutation[i];
+		rank = rank * (count - i) + value - (smaller >> (value * 4) & 15);
+		smaller += 0x1111111111111111ull << (value * 4) << 4;
+	}
+	return rank;
+}
+
+void set_permutation_rank(uint8_t *permutation, intpos count, uint32_t rank) {
+	intpos digits[16];
+	for (intpos i = count; i-- > 0;) {
+		digits[i] = rank % (count - i);
+		rank /= count - i;
+	}
+
+	// each digit picks from the values that are not used yet, kept 4 bits each in increasing order
+	uint64_t left = 0xfedcba9876543210ull;
+	for (intpos i = 0; i < count; ++i) {
+		intpos shift = digits[i] * 4;
+		permutation[i] = left >> shift & 15;
+		left = (left & ((1ull << shift) - 1)) | (left >> 4 >> shift << shift);
+	}
+}
+
+uint16_t get_twist(const struct cubie_cube *cube) {
+	uint16_t twist = 0;
+	for (intpos i = 0; i < 7; ++i) twist = twist * 3 + CORNER_ORIENTATION(cube->corners[i]);
+	return twist;
+}
+
+void set_twist(struct cubie_cube *cube, uint16_t twist) {
+	intpos sum = 0;
+	for (intpos i = 7; i-- > 0;) {
+		intpos orientation = twist % 3;
+		twist /= 3;
+		sum += orientation;
+		cube->corners[i] = MAKE_CORNER(CORNER_PIECE(cube->corners[i]), orientation);
+	}
+	cube->corners[7] = MAKE_CORNER(CORNER_PIECE(cube->corners[7]), (3 - sum % 3) % 3);
+}
+
+uint16_t get_flip(const struct cubie_cube *cube) {
+	uint16_t flip = 0;
+	for (intpos i = 0; i < 11; ++i) flip = flip * 2 + EDGE_ORIENTATION(cube->edges[i]);
+	return flip;
+}
+
+void set_flip(struct cubie_cube *cube, uint16_t flip) {
+	intpos sum = 0;
+	for (intpos i = 11; i-- > 0;) {
+		intpos orientation = flip % 2;
+		flip /= 2;
+		sum += orientation;
+		cube->edges[i] = MAKE_EDGE(EDGE_PIECE(cube->edges[i]), orientation);
+	}
+	cube->edges[11] = MAKE_EDGE(EDGE_PIECE(cube->edges[11]), sum % 2);
+}
+
+uint16_t get_slice_sorted(const struct cubie_cube *cube) {
+	// combination of the 4 positions holding middle layer edges, then the order of those edges
+	uint32_t combination = 0;
+	uint8_t order[4];
+	for (intpos i = 12, found = 0; i-- > 0;) {
+		intpos piece = EDGE_PIECE(cube->edges[i]);
+		if (piece < FR) continue;
+		combination += get_binomial(11 - i, found + 1);
+		order[3 - found] = piece - FR;
+		++found;
+	}
+	return combination * 24 + get_permutation_rank(order, 4);
+}
+
+void set_slice_sorted(struct cubie_cube *cube, uint16_t slice_sorted) {
+	uint32_t combination = slice_sorted / 24;
+	uint8_t order[4];
+	set_permutation_rank(order, 4, slice_sorted % 24);
+
+	intpos remaining = 4, other = UR;
+	for (intpos i = 0; i < 12; ++i) {
+		intpos piece;
+		uint32_t binomial = get_binomial(11 - i, remaining);
+		if (remaining && combination >= binomial) {
+			combination -= binomial;
+			piece = FR + order[4 - remaining];
+			--remaining;
+		} else {
+			piece = other++;
+		}
+		cube->edges[i] = MAKE_EDGE(piece, EDGE_ORIENTATION(cube->edges[i]));
+	}
+}
+
+uint16_t get_corners(const struct cubie_cube *cube) {
+	uint8_t permutation[8];
+	for (intpos i = 0; i < 8; ++i) permutation[i] = CORNER_PIECE(cube->corners[i]);
+	return get_permutation_rank(permutation, 8);
+}
+
+void set_corners(struct cubie_cube *cube, uint16_t corners) {
+	uint8_t permutation[8];
+	set_permutation_rank(permutation, 8, corners);
+	for (intpos i = 0; i < 8; ++i) cube->corners[i] = MAKE_CORNER(permutation[i], CORNER_ORIENTATION(cube->corners[i]));
+}
+
+uint16_t get_ud_edges(const struct cubie_cube *cube) {
+	uint8_t permutation[8];
+	for (intpos i = 0; i < 8; ++i) {
+		permutation[i] = EDGE_PIECE(cube->edges[i]);
+		if (permutation[i] >= FR) return COORD_INVALID;
+	}
+	return get_permutation_rank(permutation, 8);
+}
+
+void set_ud_edges(struct cubie_cube *cube, uint16_t ud_edges) {
+	// the middle layer edges are put back in the middle layer
+	uint8_t permutation[8];
+	set_permutation_rank(permutation, 8, ud_edges);
+	for (intpos i = 0; i < 8; ++i) cube->edges[i] = MAKE_EDGE(permutation[i], EDGE_ORIENTATION(cube->edges[i]));
+	for (intpos i = 8; i < 12; ++i) cube->edges[i] = MAKE_EDGE(i, EDGE_ORIENTATION(cube->edges[i]));
+}
+
+// fills a move table by setting each coordinate on a solved cube and applying every move
+static void build_move_table(uint16_t (*table)[CUBIE_MOVE_COUNT], uint32_t count, void (*set)(struct cubie_cube *, uint16_t), uint16_t (*get)(const struct cubie_cube *)) {
+	for (uint32_t coord = 0; coord < count; ++coord) {
+		struct cubie_cube cube;
+		reset_cubie(&cube);
+		set(&cube, coord);
+		for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+			struct cubie_cube moved;
+			multiply_cubie(&moved, &cube, get_cubie_move(move));
+			table[coord][move] = get(&moved);
+		}
+	}
+}
+
+static bool build_coord_tables(void *data, size_t size, void *userdata) {
+	uint8_t *table = data;
+	build_move_table((void *) table, TWIST_COUNT, set_twist, get_twist);
+	table += TWIST_MOVE_SIZE;
+	build_move_table((void *) table, FLIP_COUNT, set_flip, get_flip);
+	table += FLIP_MOVE_SIZE;
+	build_move_table((void *) table, SLICE_SORTED_COUNT, set_slice_sorted, get_slice_sorted);
+	table += SLICE_SORTED_MOVE_SIZE;
+	build_move_table((void *) table, CORNERS_COUNT, set_corners, get_corners);
+	table += CORNERS_MOVE_SIZE;
+	build_move_table((void *) table, UD_EDGES_COUNT, set_ud_edges, get_ud_edges);
+	return true;
+}
+
+uint64_t get_coord_tables_key() {
+	return coord_tables_key;
+}
+
+void init_coord_tables() {
+	if (coord_file.data) return;
+	init_cubie_moves();
+
+	// every table is derived from the sticker moves, so they are stale whenever those change
+	coord_tables_key = COORD_TABLES_VERSION;
+	for (intpos i = 0; i < CUBIE_MOVE_COUNT; ++i) {
+		struct move move = {.face = move_faces[i / 3], .dir = i % 3};
+		coord_tables_key = hash_table_data(get_move_permutation(move), sizeof(struct permutation), coord_tables_key);
+	}
+
+	size_t size = TWIST_MOVE_SIZE + FLIP_MOVE_SIZE + SLICE_SORTED_MOVE_SIZE + CORNERS_MOVE_SIZE + UD_EDGES_MOVE_SIZE;
+	if (!load_table_file(COORD_FILE_NAME, coord_tables_key, size, build_coord_tables, NULL, &coord_file)) {
+		errx(1, "Failed to load coordinate move tables");
+	}
+
+	const uint8_t *table = coord_file.data;
+	twist_move = (const void *) table;
+	table += TWIST_MOVE_SIZE;
+	flip_move = (const void *) table;
+	table += FLIP_MOVE_SIZE;
+	slice_sorted_move = (const void *) table;
+	table += SLICE_SORTED_MOVE_SIZE;
+	corners_move = (const void *) table;
+	table += CORNERS_MOVE_SIZE;
+	ud_edges_move = (const void *) table;
+}
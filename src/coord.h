@@ -0,0 +1,38 @@
+#ifndef COORD_H
+#define COORD_H
+#include "cubie.h"
+
+// integer coordinates of parts of a cubie cube, all of them are 0 when solved
+#define TWIST_COUNT 2187         // orientation of 7 corners, the last one follows from the others
+#define FLIP_COUNT 2048          // orientation of 11 edges
+#define SLICE_COUNT 495          // positions of the 4 middle layer edges, ignoring their order
+#define SLICE_SORTED_COUNT 11880 // positions and order of the 4 middle layer edges
+#define CORNERS_COUNT 40320      // permutation of the 8 corners
+#define UD_EDGES_COUNT 40320     // permutation of the 8 U and D layer edges, only while the middle layer edges are in the middle layer
+
+// move tables map a coordinate and a move index to the coordinate after the move
+// they point into a table file, see init_coord_tables
+extern const uint16_t (*twist_move)[CUBIE_MOVE_COUNT];
+extern const uint16_t (*flip_move)[CUBIE_MOVE_COUNT];
+extern const uint16_t (*slice_sorted_move)[CUBIE_MOVE_COUNT];
+extern const uint16_t (*corners_move)[CUBIE_MOVE_COUNT];
+extern const uint16_t (*ud_edges_move)[CUBIE_MOVE_COUNT]; // COORD_INVALID for moves that take edges out of the U and D layers
+
+#define COORD_INVALID 0xffff
+
+uint16_t get_twist(const struct cubie_cube *cube);
+void set_twist(struct cubie_cube *cube, uint16_t twist);
+uint16_t get_flip(const struct cubie_cube *cube);
+void set_flip(struct cubie_cube *cube, uint16_t flip);
+uint16_t get_slice_sorted(const struct cubie_cube *cube);
+void set_slice_sorted(struct cubie_cube *cube, uint16_t slice_sorted);
+uint16_t get_corners(const struct cubie_cube *cube);
+void set_corners(struct cubie_cube *cube, uint16_t corners);
+uint16_t get_ud_edges(const struct cubie_cube *cube);
+void set_ud_edges(struct cubie_cube *cube, uint16_t ud_edges);
+uint32_t get_permutation_rank(const uint8_t *permutation, intpos count);
+void set_permutation_rank(uint8_t *permutation, intpos count, uint32_t rank);
+uint32_t get_binomial(intpos n, intpos k);
+void init_coord_tables();
+uint64_t get_coord_tables_key();
+#endif //COORD_H
@@ -0,0 +1,291 @@
+#include <string.h>
+#include "cubie.h"
+
+// a single sticker, faces are 0 U, 1 F, 2 R, 3 B, 4 L, 5 D
+struct facelet {
+	intpos face;
+	enum stickers sticker;
+};
+
+// stickers of each corner position, starting with the U or D sticker and going clockwise
+static const struct facelet corner_facelets[8][3] = {
+        [URF] = {{0, bottom_right}, {2, top_left}, {1, top_right}},
+        [UFL] = {{0, bottom_left}, {1, top_left}, {4, top_right}},
+        [ULB] = {{0, top_left}, {4, top_left}, {3, top_right}},
+        [UBR] = {{0, top_right}, {3, top_left}, {2, top_right}},
+        [DFR] = {{5, top_right}, {1, bottom_right}, {2, bottom_left}},
+        [DLF] = {{5, top_left}, {4, bottom_right}, {1, bottom_left}},
+        [DBL] = {{5, bottom_left}, {3, bottom_right}, {4, bottom_left}},
+        [DRB] = {{5, bottom_right}, {2, bottom_right}, {3, bottom_left}},
+};
+
+// stickers of each edge position, starting with the U or D sticker, or the F or B sticker for the middle layer
+static const struct facelet edge_facelets[12][2] = {
+        [UR] = {{0, middle_right}, {2, top_center}},
+        [UF] = {{0, bottom_center}, {1, top_center}},
+        [UL] = {{0, middle_left}, {4, top_center}},
+        [UB] = {{0, top_center}, {3, top_center}},
+        [DR] = {{5, middle_right}, {2, bottom_center}},
+        [DF] = {{5, top_center}, {1, bottom_center}},
+        [DL] = {{5, middle_left}, {4, bottom_center}},
+        [DB] = {{5, bottom_center}, {3, bottom_center}},
+        [FR] = {{1, middle_right}, {2, middle_left}},
+        [FL] = {{1, middle_left}, {4, middle_right}},
+        [BL] = {{3, middle_right}, {4, middle_left}},
+        [BR] = {{3, middle_left}, {2, middle_right}},
+};
+
+// face on the opposite side of each face
+static const intpos opposite_faces[6] = {5, 3, 4, 1, 2, 0};
+
+static const char *const cubie_error_strings[] = {
+        [CUBIE_OK] = "Valid cube",
+        [CUBIE_INVALID_CENTERS] = "Centers are not a valid rotation of the cube",
+        [CUBIE_INVALID_CORNER] = "Corner has invalid colors",
+        [CUBIE_INVALID_EDGE] = "Edge has invalid colors",
+        [CUBIE_DUPLICATE_CORNER] = "Corner appears more than once",
+        [CUBIE_DUPLICATE_EDGE] = "Edge appears more than once",
+        [CUBIE_TWISTED_CORNER] = "Corner is twisted",
+        [CUBIE_FLIPPED_EDGE] = "Edge is flipped",
+        [CUBIE_PARITY] = "Two pieces are swapped",
+};
+
+static struct cubie_cube cubie_moves[CUBIE_MOVE_COUNT];
+static bool cubie_moves_initialized = false;
+
+void reset_cubie(struct cubie_cube *cube) {
+	for (intpos i = 0; i < 8; ++i) cube->corners[i] = MAKE_CORNER(i, 0);
+	for (intpos i = 0; i < 12; ++i) cube->edges[i] = MAKE_EDGE(i, 0);
+}
+
+bool is_cubie_solved(const struct cubie_cube *cube) {
+	struct cubie_cube solved;
+	reset_cubie(&solved);
+	return memcmp(cube, &solved, sizeof(solved)) == 0;
+}
+
+const char *get_cubie_error_string(enum cubie_error error) {
+	if ((unsigned) error >= sizeof(cubie_error_strings) / sizeof(cubie_error_strings[0])) return "Unknown error";
+	return cubie_error_strings[error];
+}
+
+static int get_parity(const uint8_t *pieces, intpos count, uint8_t mask) {
+	int parity = 0;
+	for (intpos i = 0; i < count; ++i) {
+		for (intpos j = i + 1; j < count; ++j) {
+			if ((pieces[i] & mask) > (pieces[j] & mask)) parity ^= 1;
+		}
+	}
+	return parity;
+}
+
+int get_corner_parity(const struct cubie_cube *cube) {
+	return get_parity(cube->corners, 8, 7);
+}
+
+int get_edge_parity(const struct cubie_cube *cube) {
+	return get_parity(cube->edges, 12, 15);
+}
+
+enum cubie_error verify_cubie(const struct cubie_cube *cube) {
+	uint16_t seen_corners = 0, seen_edges = 0;
+	intpos twist = 0, flip = 0;
+
+	for (intpos i = 0; i < 8; ++i) {
+		intpos piece = CORNER_PIECE(cube->corners[i]), orientation = CORNER_ORIENTATION(cube->corners[i]);
+		if (orientation > 2) return CUBIE_INVALID_CORNER;
+		if (seen_corners & (1 << piece)) return CUBIE_DUPLICATE_CORNER;
+		seen_corners |= 1 << piece;
+		twist += orientation;
+	}
+	for (intpos i = 0; i < 12; ++i) {
+		intpos piece = EDGE_PIECE(cube->edges[i]), orientation = EDGE_ORIENTATION(cube->edges[i]);
+		if (piece >= 12 || orientation > 1) return CUBIE_INVALID_EDGE;
+		if (seen_edges & (1 << piece)) return CUBIE_DUPLICATE_EDGE;
+		seen_edges |= 1 << piece;
+		flip += orientation;
+	}
+
+	if (twist % 3) return CUBIE_TWISTED_CORNER;
+	if (flip % 2) return CUBIE_FLIPPED_EDGE;
+	if (get_corner_parity(cube) != get_edge_parity(cube)) return CUBIE_PARITY;
+	return CUBIE_OK;
+}
+
+static face_color get_facelet(const struct cube *cube, struct facelet facelet) {
+	return cube->faces[facelet.face].stickers[facelet.sticker];
+}
+
+static bool is_center_rotation(const struct cube *cube) {
+	// opposite faces need opposite colors, which leaves the 24 rotations and their 24 mirror images
+	for (intpos face = 0; face < 6; ++face) {
+		if (cube->faces[opposite_faces[face]].middle_center != opposite_faces[cube->faces[face].middle_center]) return false;
+	}
+	// the U, R and F colors go around a corner in the same direction as the faces of some corner of a solved cube, which a mirror image reverses
+	face_color u = cube->faces[0].middle_center, r = cube->faces[2].middle_center, f = cube->faces[1].middle_center;
+	for (intpos piece = 0; piece < 8; ++piece) {
+		for (intpos i = 0; i < 3; ++i) {
+			if (corner_facelets[piece][i].face == u && corner_facelets[piece][(i + 1) % 3].face == r && corner_facelets[piece][(i + 2) % 3].face == f) return true;
+		}
+	}
+	return false;
+}
+
+enum cubie_error cube_to_cubie(const struct cube *cube, struct cubie_cube *cubie) {
+	// the cube may have been turned with slice moves or rotations,
+	// so relabel every color to the face its center is currently on
+	face_color colors[256];
+	memset(colors, 0xff, sizeof(colors));
+	for (intpos face = 0; face < 6; ++face) {
+		face_color center = cube->faces[face].middle_center;
+		if (center >= 6 || colors[center] != 0xff) return CUBIE_INVALID_CENTERS;
+		colors[center] = face;
+	}
+	if (!is_center_rotation(cube)) return CUBIE_INVALID_CENTERS;
+
+	struct cube relabeled;
+	for (intpos i = 0; i < 9 * 6; ++i) relabeled.stickers[i] = colors[cube->stickers[i]];
+
+	for (intpos i = 0; i < 8; ++i) {
+		// the orientation is which sticker has the U or D color
+		intpos orientation;
+		for (orientation = 0; orientation < 3; ++orientation) {
+			face_color color = get_facelet(&relabeled, corner_facelets[i][orientation]);
+			if (color == 0 || color == 5) break;
+		}
+		if (orientation == 3) return CUBIE_INVALID_CORNER;
+
+		face_color color0 = get_facelet(&relabeled, corner_facelets[i][orientation]);
+		face_color color1 = get_facelet(&relabeled, corner_facelets[i][(orientation + 1) % 3]);
+		face_color color2 = get_facelet(&relabeled, corner_facelets[i][(orientation + 2) % 3]);
+		intpos piece;
+		for (piece = 0; piece < 8; ++piece) {
+			if (color0 == corner_facelets[piece][0].face && color1 == corner_facelets[piece][1].face && color2 == corner_facelets[piece][2].face) break;
+		}
+		if (piece == 8) return CUBIE_INVALID_CORNER;
+		cubie->corners[i] = MAKE_CORNER(piece, orientation);
+	}
+
+	for (intpos i = 0; i < 12; ++i) {
+		face_color color0 = get_facelet(&relabeled, edge_facelets[i][0]);
+		face_color color1 = get_facelet(&relabeled, edge_facelets[i][1]);
+		intpos piece;
+		for (piece = 0; piece < 12; ++piece) {
+			if (color0 == edge_facelets[piece][0].face && color1 == edge_facelets[piece][1].face) {
+				cubie->edges[i] = MAKE_EDGE(piece, 0);
+				break;
+			}
+			if (color0 == edge_facelets[piece][1].face && color1 == edge_facelets[piece][0].face) {
+				cubie->edges[i] = MAKE_EDGE(piece, 1);
+				break;
+			}
+		}
+		if (piece == 12) return CUBIE_INVALID_EDGE;
+	}
+
+	return verify_cubie(cubie);
+}
+
+void cubie_to_cube(const struct cubie_cube *cubie, struct cube *cube) {
+	for (intpos face = 0; face < 6; ++face) cube->faces[face].middle_center = face;
+
+	for (intpos i = 0; i < 8; ++i) {
+		intpos piece = CORNER_PIECE(cubie->corners[i]), orientation = CORNER_ORIENTATION(cubie->corners[i]);
+		for (intpos j = 0; j < 3; ++j) {
+			struct facelet facelet = corner_facelets[i][(j + orientation) % 3];
+			cube->faces[facelet.face].stickers[facelet.sticker] = corner_facelets[piece][j].face;
+		}
+	}
+
+	for (intpos i = 0; i < 12; ++i) {
+		intpos piece = EDGE_PIECE(cubie->edges[i]), orientation = EDGE_ORIENTATION(cubie->edges[i]);
+		for (intpos j = 0; j < 2; ++j) {
+			struct facelet facelet = edge_facelets[i][(j + orientation) % 2];
+			cube->faces[facelet.face].stickers[facelet.sticker] = edge_facelets[piece][j].face;
+		}
+	}
+}
+
+void multiply_cubie(struct cubie_cube *result, const struct cubie_cube *a, const struct cubie_cube *b) {
+	// applies b to a, the piece at position i comes from position b[i] and gains b's orientation
+	struct cubie_cube product;
+	for (intpos i = 0; i < 8; ++i) {
+		uint8_t corner_b = b->corners[i];
+		uint8_t corner_a = a->corners[CORNER_PIECE(corner_b)];
+		intpos orientation = CORNER_ORIENTATION(corner_a) + CORNER_ORIENTATION(corner_b);
+		if (orientation >= 3) orientation -= 3;
+		product.corners[i] = MAKE_CORNER(CORNER_PIECE(corner_a), orientation);
+	}
+	for (intpos i = 0; i < 12; ++i) {
+		uint8_t edge_b = b->edges[i];
+		product.edges[i] = a->edges[EDGE_PIECE(edge_b)] ^ MAKE_EDGE(0, EDGE_ORIENTATION(edge_b));
+	}
+	*result = product;
+}
+
+void invert_cubie(struct cubie_cube *result, const struct cubie_cube *cube) {
+	struct cubie_cube inverse;
+	for (intpos i = 0; i < 8; ++i) {
+		intpos orientation = CORNER_ORIENTATION(cube->corners[i]);
+		inverse.corners[CORNER_PIECE(cube->corners[i])] = MAKE_CORNER(i, (3 - orientation) % 3);
+	}
+	for (intpos i = 0; i < 12; ++i) {
+		inverse.edges[EDGE_PIECE(cube->edges[i])] = MAKE_EDGE(i, EDGE_ORIENTATION(cube->edges[i]));
+	}
+	*result = inverse;
+}
+
+void init_cubie_moves() {
+	if (cubie_moves_initialized) return;
+
+	// derive every face move from the sticker moves so both models always agree
+	for (int i = 0; i < CUBIE_MOVE_COUNT; ++i) {
+		struct move move = {.face = move_faces[i / 3], .dir = i % 3};
+		struct cube cube;
+		reset_cube(&cube);
+		make_move(&cube, move, NULL);
+		cube_to_cubie(&cube, &cubie_moves[i]);
+	}
+
+	cubie_moves_initialized = true;
+}
+
+const struct cubie_cube *get_cubie_move(int move_index) {
+	if (move_index < 0 || move_index >= CUBIE_MOVE_COUNT) return NULL;
+	init_cubie_moves();
+	return &cubie_moves[move_index];
+}
+
+void cubie_make_move_index(struct cubie_cube *cube, int move_index) {
+	if (move_index < 0 || move_index >= CUBIE_MOVE_COUNT) return;
+	init_cubie_moves();
+	multiply_cubie(cube, cube, &cubie_moves[move_index]);
+}
+
+bool cubie_make_move(struct cubie_cube *cube, struct move move) {
+	const struct cubie_cube *cubie_move = get_cubie_move(get_move_index(move));
+	if (!cubie_move) return false;
+	multiply_cubie(cube, cube, cubie_move);
+	return true;
+}
+
+bool is_canonical_move(int move_index, int previous_index) {
+	// searches skip sequences that have a shorter or equal one, previous_index is -1 at the start
+	if (previous_index < 0) return true;
+	int face = move_index / 3, previous_face = previous_index / 3;
+	if (face == previous_face) return false;
+	// opposite faces commute, so only search them in one order (U D, not D U)
+	if (face + 3 == previous_face) return false;
+	return true;
+}
+
+intpos get_corner_sticker(intpos corner, intpos index) {
+	// index into the stickers of a cube, in the same order as the orientation counts
+	struct facelet facelet = corner_facelets[corner][index];
+	return facelet.face * 9 + facelet.sticker;
+}
+
+intpos get_edge_sticker(intpos edge, intpos index) {
+	struct facelet facelet = edge_facelets[edge][index];
+	return facelet.face * 9 + facelet.sticker;
+}
@@ -0,0 +1,77 @@
+#ifndef CUBIE_H
+#define CUBIE_H
+#include "rubik.h"
+
+// cube stored as its 8 corner and 12 edge pieces instead of stickers
+// the centers are fixed, so only the 18 outer face moves can be applied
+struct cubie_cube {
+	uint8_t corners[8]; // corner piece at each position, orientation in bits 3-4
+	uint8_t edges[12];  // edge piece at each position, orientation in bit 4
+};
+
+enum corner {
+	URF,
+	UFL,
+	ULB,
+	UBR,
+	DFR,
+	DLF,
+	DBL,
+	DRB,
+};
+
+enum edge {
+	UR,
+	UF,
+	UL,
+	UB,
+	DR,
+	DF,
+	DL,
+	DB,
+	FR,
+	FL,
+	BL,
+	BR,
+};
+
+#define CORNER_PIECE(corner_) ((corner_) & 7)
+#define CORNER_ORIENTATION(corner_) ((corner_) >> 3)
+#define MAKE_CORNER(piece_, orientation_) ((piece_) | ((orientation_) << 3))
+#define EDGE_PIECE(edge_) ((edge_) & 15)
+#define EDGE_ORIENTATION(edge_) ((edge_) >> 4)
+#define MAKE_EDGE(piece_, orientation_) ((piece_) | ((orientation_) << 4))
+
+// number of moves a cubie cube supports, these have the same index as get_move_index
+#define CUBIE_MOVE_COUNT 18
+
+enum cubie_error {
+	CUBIE_OK,
+	CUBIE_INVALID_CENTERS,
+	CUBIE_INVALID_CORNER,
+	CUBIE_INVALID_EDGE,
+	CUBIE_DUPLICATE_CORNER,
+	CUBIE_DUPLICATE_EDGE,
+	CUBIE_TWISTED_CORNER,
+	CUBIE_FLIPPED_EDGE,
+	CUBIE_PARITY,
+};
+
+void init_cubie_moves();
+void reset_cubie(struct cubie_cube *cube);
+bool is_cubie_solved(const struct cubie_cube *cube);
+const char *get_cubie_error_string(enum cubie_error error);
+enum cubie_error verify_cubie(const struct cubie_cube *cube);
+enum cubie_error cube_to_cubie(const struct cube *cube, struct cubie_cube *cubie);
+void cubie_to_cube(const struct cubie_cube *cubie, struct cube *cube);
+void multiply_cubie(struct cubie_cube *result, const struct cubie_cube *a, const struct cubie_cube *b);
+void invert_cubie(struct cubie_cube *result, const struct cubie_cube *cube);
+const struct cubie_cube *get_cubie_move(int move_index);
+bool cubie_make_move(struct cubie_cube *cube, struct move move);
+void cubie_make_move_index(struct cubie_cube *cube, int move_index);
+bool is_canonical_move(int move_index, int previous_index);
+intpos get_corner_sticker(intpos corner, intpos index);
+intpos get_edge_sticker(intpos edge, intpos index);
+int get_corner_parity(const struct cubie_cube *cube);
+int get_edge_parity(const struct cubie_cube *cube);
+#endif //CUBIE_H
@@ -0,0 +1,260 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "generator.h"
+#include "err.h"
+#include "util.h"
+
+// the first moves of every sequence are split into tasks shared by the threads
+#define MAX_SPLIT_DEPTH 6
+// split deeper until there are this many tasks per thread
+#define TASKS_PER_THREAD 16
+
+static const char *const mask_names[MASK_COUNT] = {
+        [MASK_FULL] = "full",
+        [MASK_F2L] = "f2l",
+        [MASK_OLL] = "oll",
+};
+
+struct generator_move {
+	struct move move;
+	const struct permutation *permutation;
+	int face;       // index of the face in the move set
+	enum axis axis; // moves on the same axis commute
+};
+
+struct generator_task {
+	struct cube cube;
+	int path[MAX_SPLIT_DEPTH];
+};
+
+struct generator {
+	const struct generator_options *options;
+	struct generator_move moves[MOVE_COUNT];
+	int move_count;
+	intpos mask[9 * 6]; // stickers that have to match a solved cube
+	size_t mask_count;
+
+	struct generator_task *tasks;
+	size_t task_count;
+	int split_depth;
+
+	int depth; // length of the algorithms being searched for
+	atomic_size_t next_task;
+	atomic_uint_fast64_t nodes;
+	uint64_t solutions;
+	pthread_mutex_t output_lock;
+};
+
+struct generator_worker {
+	struct generator *generator;
+	int path[GENERATOR_MAX_DEPTH];
+	uint64_t nodes;
+};
+
+bool parse_generator_mask(const char *text, enum generator_mask *mask) {
+	for (enum generator_mask i = 0; i < MASK_COUNT; ++i) {
+		if (strcmp(text, mask_names[i]) == 0) {
+			*mask = i;
+			return true;
+		}
+	}
+	warnx("Invalid mask: %s, expected full, f2l or oll", text);
+	return false;
+}
+
+static void init_mask(struct generator *generator, enum generator_mask mask) {
+	generator->mask_count = 0;
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		intpos face = i / 9, row = i % 9 / 3;
+		bool used;
+		switch (mask) {
+			case MASK_F2L:
+				// the top row of each side face touches the U face
+				used = face == 5 || (face != 0 && row > 0) || i == 4;
+				break;
+			case MASK_OLL:
+				used = face == 0 || face == 5 || row > 0;
+				break;
+			default:
+				used = true;
+				break;
+		}
+		if (used) generator->mask[generator->mask_count++] = i;
+	}
+}
+
+static bool is_case_solved(const struct generator *generator, const struct cube *cube) {
+	// a solved cube has the color of each face on all of its stickers
+	for (size_t i = 0; i < generator->mask_count; ++i) {
+		intpos sticker = generator->mask[i];
+		if (cube->stickers[sticker] != sticker / 9) return false;
+	}
+	return true;
+}
+
+static bool is_canonical(const struct generator *generator, int move, int previous) {
+	if (previous < 0) return true;
+	const struct generator_move *a = &generator->moves[previous], *b = &generator->moves[move];
+	if (a->axis != b->axis) return true;
+	// commuting moves are only searched with their faces in the order of the move set, which also never turns a face twice in a row
+	return b->face > a->face;
+}
+
+static void move_cube(const struct cube *from, struct cube *to, const struct permutation *permutation) {
+	for (intpos i = 0; i < 9 * 6; ++i) to->stickers[i] = from->stickers[permutation->stickers[i]];
+}
+
+static void emit_solution(struct generator_worker *worker, int length) {
+	struct generator *generator = worker->generator;
+	struct move moves[GENERATOR_MAX_DEPTH];
+	for (int i = 0; i < length; ++i) moves[i] = generator->moves[worker->path[i]].move;
+
+	pthread_mutex_lock(&generator->output_lock);
+	++generator->solutions;
+	generator->options->on_solution(moves, length, generator->options->userdata);
+	pthread_mutex_unlock(&generator->output_lock);
+}
+
+static void search(struct generator_worker *worker, const struct cube *cube, int depth, int togo) {
+	struct generator *generator = worker->generator;
+	++worker->nodes;
+	if (togo == 0) {
+		if (is_case_solved(generator, cube)) emit_solution(worker, depth);
+		return;
+	}
+
+	int previous = depth > 0 ? worker->path[depth - 1] : -1;
+	struct cube next;
+	for (int move = 0; move < generator->move_count; ++move) {
+		if (!is_canonical(generator, move, previous)) continue;
+		move_cube(cube, &next, generator->moves[move].permutation);
+		worker->path[depth] = move;
+		search(worker, &next, depth + 1, togo - 1);
+	}
+}
+
+static void *generator_thread(void *data) {
+	struct generator_worker *worker = data;
+	struct generator *generator = worker->generator;
+	for (;;) {
+		size_t index = atomic_fetch_add(&generator->next_task, 1);
+		if (index >= generator->task_count) break;
+		const struct generator_task *task = &generator->tasks[index];
+		memcpy(worker->path, task->path, sizeof(int) * generator->split_depth);
+		search(worker, &task->cube, generator->split_depth, generator->depth - generator->split_depth);
+	}
+	atomic_fetch_add(&generator->nodes, worker->nodes);
+	return NULL;
+}
+
+static bool split_tasks(struct generator *generator, int max_split_depth, size_t wanted_tasks) {
+	// every canonical sequence of the first few moves, one level at a time
+	generator->tasks = malloc(sizeof(struct generator_task));
+	if (!generator->tasks) goto fail;
+	generator->tasks[0].cube = generator->options->start;
+	generator->task_count = 1;
+	generator->split_depth = 0;
+
+	while (generator->split_depth < max_split_depth && generator->task_count < wanted_tasks) {
+		int depth = generator->split_depth;
+		struct generator_task *tasks = malloc(generator->task_count * generator->move_count * sizeof(struct generator_task));
+		if (!tasks) goto fail;
+		size_t count = 0;
+		for (size_t i = 0; i < generator->task_count; ++i) {
+			const struct generator_task *task = &generator->tasks[i];
+			int previous = depth > 0 ? task->path[depth - 1] : -1;
+			for (int move = 0; move < generator->move_count; ++move) {
+				if (!is_canonical(generator, move, previous)) continue;
+				struct generator_task *next = &tasks[count++];
+				memcpy(next->path, task->path, sizeof(int) * depth);
+				next->path[depth] = move;
+				move_cube(&task->cube, &next->cube, generator->moves[move].permutation);
+			}
+		}
+		free(generator->tasks);
+		generator->tasks = tasks;
+		generator->task_count = count;
+		++generator->split_depth;
+	}
+	return true;
+fail:
+	warn("Failed to allocate generator tasks");
+	free(generator->tasks);
+	generator->tasks = NULL;
+	return false;
+}
+
+static void search_parallel(struct generator *generator, int thread_count) {
+	atomic_store(&generator->next_task, 0);
+	struct generator_worker workers[thread_count];
+	pthread_t threads[thread_count];
+
+	// this thread is worker 0
+	int started = 1;
+	for (int i = 0; i < thread_count; ++i) workers[i] = (struct generator_worker){.generator = generator, .nodes = 0};
+	for (; started < thread_count; ++started) {
+		if (pthread_create(&threads[started], NULL, generator_thread, &workers[started]) != 0) {
+			warnx("Failed to start generator thread");
+			break;
+		}
+	}
+	generator_thread(&workers[0]);
+	for (int i = 1; i < started; ++i) pthread_join(threads[i], NULL);
+}
+
+bool generate_algorithms(const struct generator_options *options, struct generator_stats *stats) {
+	if (options->max_depth > GENERATOR_MAX_DEPTH) {
+		warnx("Algorithms can be at most %d moves long", GENERATOR_MAX_DEPTH);
+		return false;
+	}
+	init_move_tables();
+	*stats = (struct generator_stats){0};
+
+	struct generator generator = {.options = options, .move_count = 0, .solutions = 0};
+	atomic_init(&generator.nodes, 0);
+	for (size_t i = 0; i < options->face_count; ++i) {
+		for (enum move_direction dir = cw; dir <= dbl; ++dir) {
+			struct move move = {.face = options->faces[i], .dir = dir};
+			if (!get_move_permutation(move)) {
+				warnx("Invalid move face '%c'", options->faces[i]);
+				return false;
+			}
+			generator.moves[generator.move_count++] = (struct generator_move){
+			        .move = move,
+			        .permutation = get_move_permutation(move),
+			        .face = i,
+			        .axis = get_move_animation(move)->axis,
+			};
+		}
+	}
+	init_mask(&generator, options->mask);
+
+	int thread_count = options->threads > 0 ? options->threads : 1;
+	if (!split_tasks(&generator, options->max_depth < MAX_SPLIT_DEPTH ? options->max_depth : MAX_SPLIT_DEPTH, (size_t) thread_count * TASKS_PER_THREAD)) return false;
+	pthread_mutex_init(&generator.output_lock, NULL);
+
+	// one length at a time, so shorter algorithms come first
+	uint64_t start = get_time_ns();
+	for (int depth = 1; depth <= options->max_depth; ++depth) {
+		generator.depth = depth;
+		if (depth <= generator.split_depth) {
+			// too short to split into tasks
+			struct generator_worker worker = {.generator = &generator, .nodes = 0};
+			search(&worker, &options->start, 0, depth);
+			atomic_fetch_add(&generator.nodes, worker.nodes);
+		} else {
+			search_parallel(&generator, thread_count);
+		}
+
+		stats->nodes = atomic_load(&generator.nodes);
+		stats->solutions = generator.solutions;
+		stats->time_ns = get_time_ns() - start;
+		if (options->on_depth) options->on_depth(depth, stats, options->userdata);
+	}
+
+	pthread_mutex_destroy(&generator.output_lock);
+	free(generator.tasks);
+	return true;
+}
@@ -0,0 +1,43 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "rubik.h"
+
+// finds every move sequence up to a length that solves a case using only some move faces
+
+#define GENERATOR_MAX_DEPTH 30
+
+// stickers that have to be solved by an algorithm
+enum generator_mask {
+	MASK_FULL, // the whole cube
+	MASK_F2L,  // the first two layers, with the U layer on top
+	MASK_OLL,  // the first two layers and the U face, the U layer may be permuted
+	MASK_COUNT,
+};
+
+struct generator_stats {
+	uint64_t nodes;
+	uint64_t solutions;
+	uint64_t time_ns;
+};
+
+struct generator_options {
+	struct cube start; // the case, usually the inverse of an algorithm applied to a solved cube
+	enum move_face faces[MOVE_FACE_COUNT];
+	size_t face_count;
+	enum generator_mask mask;
+	int max_depth;
+	int threads;
+
+	// called with each algorithm, shortest ones first, only one call runs at a time
+	void (*on_solution)(const struct move *moves, size_t count, void *userdata);
+	// called once every algorithm of a length has been found, may be NULL
+	void (*on_depth)(int depth, const struct generator_stats *stats, void *userdata);
+	void *userdata;
+};
+
+bool parse_generator_mask(const char *text, enum generator_mask *mask);
+bool generate_algorithms(const struct generator_options *options, struct generator_stats *stats);
+#endif //GENERATOR_H
@@ -0,0 +1,70 @@
+#include "hash.h"
+#include "random.h"
+
+// one random key per sticker and color, a hash is all the keys of a cube xored together
+static struct cube_hash sticker_keys[9 * 6][6];
+
+// stickers each move changes, a face turn changes 20 of the 54
+static struct hash_move {
+	intpos stickers[9 * 6];
+	intpos count;
+} hash_moves[MOVE_COUNT];
+
+static bool hash_init = false;
+
+void init_cube_hash() {
+	if (hash_init) return;
+	hash_init = true;
+	init_move_tables();
+
+	// fixed seed, so hashes are the same in every run and can be stored
+	uint64_t seed = 0x52554249434b4559ull;
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		for (intpos color = 0; color < 6; ++color) {
+			sticker_keys[i][color].low = splitmix64(&seed);
+			sticker_keys[i][color].high = splitmix64(&seed);
+		}
+	}
+
+	for (int index = 0; index < MOVE_COUNT; ++index) {
+		struct move move = {.face = move_faces[index / 3], .dir = index % 3};
+		const struct permutation *permutation = get_move_permutation(move);
+		struct hash_move *hash_move = &hash_moves[index];
+		hash_move->count = 0;
+		for (intpos i = 0; i < 9 * 6; ++i) {
+			if (permutation->stickers[i] != i) hash_move->stickers[hash_move->count++] = i;
+		}
+	}
+}
+
+struct cube_hash hash_cube(const struct cube *cube) {
+	init_cube_hash();
+	struct cube_hash hash = {0, 0};
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		hash.low ^= sticker_keys[i][cube->stickers[i]].low;
+		hash.high ^= sticker_keys[i][cube->stickers[i]].high;
+	}
+	return hash;
+}
+
+void make_move_hashed(struct cube *cube, struct cube_hash *hash, struct move move) {
+	// like make_move, but only touches the stickers that change and updates the hash from them
+	int index = get_move_index(move);
+	if (index < 0) return;
+	init_cube_hash();
+
+	const struct permutation *permutation = get_move_permutation(move);
+	const struct hash_move *hash_move = &hash_moves[index];
+	struct cube old_cube = *cube;
+	for (intpos j = 0; j < hash_move->count; ++j) {
+		intpos i = hash_move->stickers[j];
+		face_color old_color = old_cube.stickers[i], new_color = old_cube.stickers[permutation->stickers[i]];
+		hash->low ^= sticker_keys[i][old_color].low ^ sticker_keys[i][new_color].low;
+		hash->high ^= sticker_keys[i][old_color].high ^ sticker_keys[i][new_color].high;
+		cube->stickers[i] = new_color;
+	}
+}
+
+bool is_same_hash(struct cube_hash a, struct cube_hash b) {
+	return a.low == b.low && a.high == b.high;
+}
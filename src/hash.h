@@ -0,0 +1,16 @@
+#ifndef HASH_H
+#define HASH_H
+#include <stdbool.h>
+#include <stdint.h>
+#include "rubik.h"
+
+// zobrist hash of the stickers of a cube, colors have to be 0 to 5 like after reset_cube
+struct cube_hash {
+	uint64_t low, high;
+};
+
+void init_cube_hash();
+struct cube_hash hash_cube(const struct cube *cube);
+void make_move_hashed(struct cube *cube, struct cube_hash *hash, struct move move);
+bool is_same_hash(struct cube_hash a, struct cube_hash b);
+#endif //HASH_H
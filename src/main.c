@@ -1,5 +1,8 @@
 #include <stdio.h>
 #include <stdbool.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <limits.h>
 #include "err.h"
 
 #include <SDL2/SDL.h>
@@ -9,13 +12,269 @@
 #include "rubik.h"
 #include "render.h"
 #include "moves.h"
+#include "bench.h"
+#include "coord.h"
+#include "cli.h"
+#include "optimal.h"
+#include "generator.h"
+#include "random.h"
+#include "record.h"
 
 struct cube cube;
 
+static void print_usage(FILE *file) {
+	fprintf(file, "Usage: %s [options]\n"
+	              "Options:\n"
+	              "  -h, --help              Show this help\n"
+	              "  -V, --version           Show the version\n"
+	              "  --bench                 Measure move throughput without opening a window\n"
+	              "  --solve SCRAMBLE        Solve the cube after SCRAMBLE, or given as 54 facelets, without opening a window\n"
+	              "  --solve-batch[=FILE]    Solve one scramble or facelet string per line of FILE or stdin\n"
+	              "  --unordered             Write batch results as they finish instead of in input order\n"
+	              "  --max-length MOVES      Stop solving once a solution this short is found (default 22)\n"
+	              "  --time-limit MS         Stop looking for shorter solutions after MS milliseconds (default 1000)\n"
+	              "  --threads N             Number of threads used by the solver (default is the number of cpus)\n"
+	              "  --optimal               Find shortest solutions instead, ignores --max-length and --time-limit\n"
+	              "  --pattern-edges N       Edges in each pattern database of the optimal solver, 5 to 7 (default 6)\n"
+	              "                          each step up uses 6 to 7 times the memory and makes the search faster\n"
+	              "  --transposition MB      Size of the table of states the optimal solver has already searched, 0 for none (default 64)\n"
+	              "  --replacement POLICY    Replacement policy of that table and the --bench one, always, depth or age (default age)\n"
+	              "  --generate MOVES        Find every algorithm using only the faces in MOVES, such as RU or <R,U,F>\n"
+	              "  --case SCRAMBLE         Case the algorithms solve, as a scramble or 54 facelets (default solved)\n"
+	              "  --mask MASK             Part of the cube the algorithms solve, full, f2l or oll (default full)\n"
+	              "  --depth MOVES           Longest algorithm to look for (default 10)\n"
+	              "  --bfs MOVES             Count the states at each distance in the group the faces in MOVES make\n"
+	              "  --pieces PIECES         Pieces of the --bfs states, all, corners or edges (default all)\n"
+	              "  --scramble N            Write N scrambles of random states, solved with --max-length and --threads\n"
+	              "  --seed SEED             Seed of the --scramble states, the same seed always gives the same scrambles\n"
+	              "  --facelets              Write the --scramble states as 54 facelets instead of solving them\n"
+	              "  --record FILE           Log every move of the session to FILE\n"
+	              "  --replay FILE           Replay a logged session without a window as fast as possible and check its final cube\n"
+	              "  --replay-gui FILE       Play a logged session in the window at the times it was recorded\n"
+	              "  --speed SPEED           Speed of --replay-gui, 2 is twice as fast, 0 plays every move at once (default 1)\n",
+	        TARGET);
+}
+
+static bool parse_decimal(const char *text, double min, double max, double *number) {
+	char *end;
+	double value = strtod(text, &end);
+	if (!*text || *end || !(value >= min && value <= max)) {
+		warnx("Invalid number: %s", text);
+		return false;
+	}
+	*number = value;
+	return true;
+}
+
+static bool parse_number(const char *text, long min, long max, long *number) {
+	char *end;
+	long value = strtol(text, &end, 10);
+	if (!*text || *end || value < min || value > max) {
+		warnx("Invalid number: %s", text);
+		return false;
+	}
+	*number = value;
+	return true;
+}
+
 int main(int argc, char *argv[]) {
 	int ret = 1;
 	bool render_init = false;
 
+	// region command line options
+	enum {
+		OPT_BENCH = 0x100,
+		OPT_SOLVE,
+		OPT_SOLVE_BATCH,
+		OPT_UNORDERED,
+		OPT_MAX_LENGTH,
+		OPT_TIME_LIMIT,
+		OPT_THREADS,
+		OPT_OPTIMAL,
+		OPT_PATTERN_EDGES,
+		OPT_TRANSPOSITION,
+		OPT_REPLACEMENT,
+		OPT_GENERATE,
+		OPT_CASE,
+		OPT_MASK,
+		OPT_DEPTH,
+		OPT_BFS,
+		OPT_PIECES,
+		OPT_SCRAMBLE,
+		OPT_SEED,
+		OPT_FACELETS,
+		OPT_RECORD,
+		OPT_REPLAY,
+		OPT_REPLAY_GUI,
+		OPT_SPEED,
+	};
+	static const struct option long_options[] = {
+	        {"help",          no_argument,       NULL, 'h'              },
+	        {"version",       no_argument,       NULL, 'V'              },
+	        {"bench",         no_argument,       NULL, OPT_BENCH        },
+	        {"solve",         required_argument, NULL, OPT_SOLVE        },
+	        {"solve-batch",   optional_argument, NULL, OPT_SOLVE_BATCH  },
+	        {"unordered",     no_argument,       NULL, OPT_UNORDERED    },
+	        {"max-length",    required_argument, NULL, OPT_MAX_LENGTH   },
+	        {"time-limit",    required_argument, NULL, OPT_TIME_LIMIT   },
+	        {"threads",       required_argument, NULL, OPT_THREADS      },
+	        {"optimal",       no_argument,       NULL, OPT_OPTIMAL      },
+	        {"pattern-edges", required_argument, NULL, OPT_PATTERN_EDGES},
+	        {"transposition", required_argument, NULL, OPT_TRANSPOSITION},
+	        {"replacement",   required_argument, NULL, OPT_REPLACEMENT  },
+	        {"generate",      required_argument, NULL, OPT_GENERATE     },
+	        {"case",          required_argument, NULL, OPT_CASE         },
+	        {"mask",          required_argument, NULL, OPT_MASK         },
+	        {"depth",         required_argument, NULL, OPT_DEPTH        },
+	        {"bfs",           required_argument, NULL, OPT_BFS          },
+	        {"pieces",        required_argument, NULL, OPT_PIECES       },
+	        {"scramble",      required_argument, NULL, OPT_SCRAMBLE     },
+	        {"seed",          required_argument, NULL, OPT_SEED         },
+	        {"facelets",      no_argument,       NULL, OPT_FACELETS     },
+	        {"record",        required_argument, NULL, OPT_RECORD       },
+	        {"replay",        required_argument, NULL, OPT_REPLAY       },
+	        {"replay-gui",    required_argument, NULL, OPT_REPLAY_GUI   },
+	        {"speed",         required_argument, NULL, OPT_SPEED        },
+	        {NULL,            0,                 NULL, 0                },
+	};
+
+	bool bench = false;
+	const char *solve = NULL;
+	bool solve_batch = false, unordered = false;
+	const char *batch_path = NULL;
+	const char *generate = NULL, *generate_case = NULL, *generate_mask = NULL;
+	int generate_depth = 10;
+	const char *bfs = NULL, *bfs_pieces = NULL;
+	long scramble_count = -1;
+	bool has_seed = false, facelets = false;
+	uint64_t seed = 0;
+	const char *record = NULL, *replay = NULL, *replay_gui = NULL;
+	double replay_speed = 1;
+	struct replay gui_replay = {.file = NULL};
+	struct solve_options solve_options = get_default_solve_options();
+	long number;
+	int opt;
+	while ((opt = getopt_long(argc, argv, "hV", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'h':
+				print_usage(stdout);
+				return 0;
+			case 'V':
+#ifdef VERSION
+				printf("%s %s\n", TARGET, VERSION);
+#else
+				printf("%s\n", TARGET);
+#endif
+				return 0;
+			case OPT_BENCH:
+				bench = true;
+				break;
+			case OPT_SOLVE:
+				solve = optarg;
+				break;
+			case OPT_SOLVE_BATCH:
+				solve_batch = true;
+				batch_path = optarg;
+				break;
+			case OPT_UNORDERED:
+				unordered = true;
+				break;
+			case OPT_MAX_LENGTH:
+				if (!parse_number(optarg, 0, MAX_SOLUTION_LENGTH, &number)) return 1;
+				solve_options.target_length = number;
+				break;
+			case OPT_TIME_LIMIT:
+				if (!parse_number(optarg, 0, 3600000, &number)) return 1;
+				solve_options.time_limit_ns = number * 1000000ull;
+				break;
+			case OPT_THREADS:
+				if (!parse_number(optarg, 1, 256, &number)) return 1;
+				solve_options.threads = number;
+				break;
+			case OPT_OPTIMAL:
+				solve_options.optimal = true;
+				break;
+			case OPT_PATTERN_EDGES:
+				if (!parse_number(optarg, MIN_PATTERN_EDGES, MAX_PATTERN_EDGES, &number)) return 1;
+				solve_options.pattern_edges = number;
+				break;
+			case OPT_TRANSPOSITION:
+				if (!parse_number(optarg, 0, 65536, &number)) return 1;
+				solve_options.transposition_mb = number;
+				break;
+			case OPT_REPLACEMENT:
+				if (!parse_replacement_policy(optarg, &solve_options.replacement)) return 1;
+				break;
+			case OPT_GENERATE:
+				generate = optarg;
+				break;
+			case OPT_CASE:
+				generate_case = optarg;
+				break;
+			case OPT_MASK:
+				generate_mask = optarg;
+				break;
+			case OPT_DEPTH:
+				if (!parse_number(optarg, 1, GENERATOR_MAX_DEPTH, &number)) return 1;
+				generate_depth = number;
+				break;
+			case OPT_BFS:
+				bfs = optarg;
+				break;
+			case OPT_PIECES:
+				bfs_pieces = optarg;
+				break;
+			case OPT_SCRAMBLE:
+				if (!parse_number(optarg, 0, LONG_MAX, &number)) return 1;
+				scramble_count = number;
+				break;
+			case OPT_SEED:
+				if (!parse_number(optarg, 0, LONG_MAX, &number)) return 1;
+				seed = number;
+				has_seed = true;
+				break;
+			case OPT_FACELETS:
+				facelets = true;
+				break;
+			case OPT_RECORD:
+				record = optarg;
+				break;
+			case OPT_REPLAY:
+				replay = optarg;
+				break;
+			case OPT_REPLAY_GUI:
+				replay_gui = optarg;
+				break;
+			case OPT_SPEED:
+				if (!parse_decimal(optarg, 0, 1000000, &replay_speed)) return 1;
+				break;
+			default:
+				print_usage(stderr);
+				return 1;
+		}
+	}
+	if (optind < argc) {
+		warnx("Unexpected argument: %s", argv[optind]);
+		print_usage(stderr);
+		return 1;
+	}
+
+	if (bench) return run_benchmark(solve_options.replacement) ? 0 : 1;
+	if (solve) return run_solve(solve, &solve_options) ? 0 : 1;
+	if (generate) return run_generate(generate, generate_case, generate_mask, generate_depth, solve_options.threads) ? 0 : 1;
+	if (bfs) return run_bfs(bfs, bfs_pieces, solve_options.threads) ? 0 : 1;
+	if (solve_batch) return run_solve_batch(batch_path, &solve_options, unordered) ? 0 : 1;
+	if (replay) return run_replay(replay) ? 0 : 1;
+	if (scramble_count >= 0) {
+		// without a seed, show the one that was picked so the scrambles can be made again
+		if (!has_seed) {
+			seed = get_random_seed();
+			fprintf(stderr, "Seed %llu\n", (unsigned long long) seed);
+		}
+		return run_scramble(scramble_count, seed, &solve_options, facelets) ? 0 : 1;
+	}
+	// endregion
+
 	// region SDL initialization
 	SDL_Window *window = NULL;
 	SDL_GLContext context = NULL;
@@ -45,6 +304,8 @@ int main(int argc, char *argv[]) {
 
 	bool loop = true;
 
+	init_move_tables();
+	init_coord_tables();
 	reset_cube(&cube);
 
 	// Enable vsync
@@ -56,7 +317,14 @@ int main(int argc, char *argv[]) {
 
 	render_init = 1;
 
-	init_moves();
+	if (!init_moves()) goto exit;
+	// a replay starts from the cube its session started from
+	if (replay_gui) {
+		if (!open_replay(replay_gui, &gui_replay)) goto exit;
+		cube = gui_replay.start;
+		if (!start_replay_thread(&gui_replay, replay_speed)) goto exit;
+	}
+	if (record && !start_recording(record, &cube)) goto exit;
 	update_cube(&cube);
 	update_turn_time();
 
@@ -163,12 +431,15 @@ int main(int argc, char *argv[]) {
 						case SDLK_BACKSPACE:
 							shuffle_cube(&cube);
 							break;
+						case SDLK_RETURN:
+							if (!queue_solution(&cube)) goto exit;
+							break;
 						default:
 							break;
 					}
 					// default because we don't want to move if the user presses an invalid letter
 					if (move.face == NO_FACE) break;
-					if (!send_move(move)) goto exit;
+					if (send_move(move, SOURCE_KEYBOARD) == SEND_FAILED) goto exit;
 					break;
 				}
 				case SDL_MOUSEBUTTONUP:
@@ -215,7 +486,8 @@ int main(int argc, char *argv[]) {
 		}
 		last_time = current_time;
 
-		update_moves(current_time, &cube);
+		if (!update_solution(&cube)) goto exit;
+		if (!update_moves(current_time, &cube)) goto exit;
 
 		glViewport((window_size.x - render_size.x) / 2, (window_size.y - render_size.y) / 2, render_size.x, render_size.y);
 
@@ -232,6 +504,9 @@ int main(int argc, char *argv[]) {
 
 	ret = 0;
 exit:
+	stop_replay_thread();
+	if (replay_gui) close_replay(&gui_replay);
+	if (!stop_recording(&cube)) ret = 1;
 	if (render_init) unload();
 	if (context) SDL_GL_DeleteContext(context);
 	if (window) SDL_DestroyWindow(window);
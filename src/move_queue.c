@@ -0,0 +1,64 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "move_queue.h"
+#include "err.h"
+
+bool init_move_queue(struct move_queue *queue, size_t capacity) {
+	if (capacity < 2 || (capacity & (capacity - 1))) {
+		warnx("Move queue capacity has to be a power of two");
+		return false;
+	}
+	queue->cells = malloc(capacity * sizeof(struct move_queue_cell));
+	if (!queue->cells) {
+		warn("Failed to allocate move queue");
+		return false;
+	}
+	// a cell is free for the producer at position p once its sequence is p
+	for (size_t i = 0; i < capacity; ++i) atomic_init(&queue->cells[i].sequence, i);
+	queue->mask = capacity - 1;
+	atomic_init(&queue->tail, 0);
+	queue->head = 0;
+	return true;
+}
+
+void free_move_queue(struct move_queue *queue) {
+	free(queue->cells);
+	queue->cells = NULL;
+	queue->mask = 0;
+}
+
+bool push_move_queue(struct move_queue *queue, struct move move) {
+	// returns false if the queue is full
+	size_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	struct move_queue_cell *cell;
+	for (;;) {
+		cell = &queue->cells[position & queue->mask];
+		size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+		intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+		if (difference == 0) {
+			// the cell is free, claim it unless another producer was faster
+			if (atomic_compare_exchange_weak_explicit(&queue->tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) break;
+		} else if (difference < 0) {
+			// the consumer has not read the cell from one lap ago yet
+			return false;
+		} else {
+			position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+		}
+	}
+	cell->move = move;
+	// hands the cell to the consumer
+	atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+	return true;
+}
+
+bool pop_move_queue(struct move_queue *queue, struct move *move) {
+	// returns false if the queue is empty, or the next move is claimed but not written yet
+	struct move_queue_cell *cell = &queue->cells[queue->head & queue->mask];
+	size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+	if (sequence != queue->head + 1) return false;
+	*move = cell->move;
+	// hands the cell back to the producers for the next lap
+	atomic_store_explicit(&cell->sequence, queue->head + queue->mask + 1, memory_order_release);
+	++queue->head;
+	return true;
+}
@@ -0,0 +1,28 @@
+#ifndef MOVE_QUEUE_H
+#define MOVE_QUEUE_H
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rubik.h"
+
+// bounded queue of moves without locks, any number of threads can push while one thread pops
+// each cell has a sequence number that tells producers and the consumer whose turn it is (dmitry vyukov's bounded queue)
+
+struct move_queue_cell {
+	atomic_size_t sequence;
+	struct move move;
+};
+
+struct move_queue {
+	struct move_queue_cell *cells;
+	size_t mask; // capacity - 1, the capacity is a power of two
+	// on their own cache lines, so producers and the consumer do not slow each other down
+	atomic_size_t tail __attribute__((aligned(64))); // next cell a producer claims
+	size_t head __attribute__((aligned(64)));        // next cell the consumer reads, only the consumer uses it
+};
+
+bool init_move_queue(struct move_queue *queue, size_t capacity);
+void free_move_queue(struct move_queue *queue);
+bool push_move_queue(struct move_queue *queue, struct move move);
+bool pop_move_queue(struct move_queue *queue, struct move *move);
+#endif //MOVE_QUEUE_H
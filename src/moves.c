@@ -1,27 +1,104 @@
 #define MOVES
 #include <stdio.h>
-#include <time.h>
+#include <string.h>
 #include "moves.h"
 #include "err.h"
+#include "move_queue.h"
 #include "render.h"
+#include "random.h"
+#include "scramble.h"
+#include "solver.h"
+
+// moves the queue has room for before it first grows
+#define MOVE_LIST_INITIAL_CAPACITY 64
+// moves applied without turning in one frame, so a huge queue does not stall the window
+#define MAX_INSTANT_MOVES 4096
+// moves other threads can post before update_moves takes them
+#define MOVE_INBOX_SIZE 4096
 
 struct move_list moves;
 int_time current_turn_time;
 
-void init_moves() {
+// moves from other threads, only update_moves reads it
+static struct move_queue inbox;
+
+// solve running in the background, and the cube it was started from
+static struct solve_job *solve_job = NULL;
+static struct cube solve_start;
+static enum move_source solve_source; // a shuffle is a solve too
+
+static void reset_moves() {
 	moves.count = 0;
 	moves.shuffle_count = 0;
-	moves.head = NULL;
-	moves.tail = NULL;
+	moves.items = NULL;
+	moves.capacity = 0;
+	moves.head = 0;
+}
+
+bool init_moves() {
+	reset_moves();
+	return init_move_queue(&inbox, MOVE_INBOX_SIZE);
+}
+
+static bool grow_moves() {
+	// doubles the buffer, the moves that wrapped around to the start go after the old end so the order stays the same
+	size_t capacity = moves.capacity ? moves.capacity * 2 : MOVE_LIST_INITIAL_CAPACITY;
+	struct queued_move *items = realloc(moves.items, capacity * sizeof(struct queued_move));
+	if (!items) {
+		warn("Failed to allocate memory for the moves");
+		return false;
+	}
+	size_t wrapped = moves.head + moves.count > moves.capacity ? moves.head + moves.count - moves.capacity : 0;
+	memcpy(items + moves.capacity, items, wrapped * sizeof(struct queued_move));
+	moves.items = items;
+	moves.capacity = capacity;
+	return true;
+}
+
+static struct queued_move *get_queued_move(size_t index) {
+	// index 0 is the next move to play
+	return &moves.items[(moves.head + index) & (moves.capacity - 1)];
+}
+
+static void remove_queued_move(size_t index) {
+	// moves the later moves down, only ever a few since they all commute with the removed one
+	for (size_t i = index; i + 1 < moves.count; ++i) *get_queued_move(i) = *get_queued_move(i + 1);
+	--moves.count;
 }
 
-static struct move shift_moves() {
-	// removes first item from linked list and returns it
-	if (moves.head == moves.tail) moves.tail = NULL;
-	struct move current = moves.head->item;
-	struct move_list_item *next = moves.head->next;
-	free(moves.head);
-	moves.head = next;
+static bool queue_move(struct move move, enum move_source source) {
+	// merges the move into a queued move of the same face if only moves on the same axis are in between, since those commute
+	// R R' cancels, U U U becomes U', R L R' becomes L
+	// the shuffle or solution at the start of the queue is left alone, and so are moves from other sources so the log shows each source's moves
+	static const int quarter_turns[] = {[cw] = 1, [ccw] = 3, [dbl] = 2};
+	static const enum move_direction directions[] = {[1] = cw, [2] = dbl, [3] = ccw};
+	const struct sticker_rotations *animation = get_move_animation(move);
+	if (!animation) {
+		warnx("Invalid move with face %d and direction %d", move.face, move.dir);
+		return false;
+	}
+
+	for (size_t i = moves.count; i-- > moves.shuffle_count;) {
+		struct queued_move *queued = get_queued_move(i);
+		if (get_move_animation(queued->move)->axis != animation->axis) break;
+		if (queued->move.face != move.face) continue;
+		if (queued->source != source) break;
+
+		int turns = (quarter_turns[queued->move.dir] + quarter_turns[move.dir]) % 4;
+		if (turns == 0) {
+			remove_queued_move(i);
+		} else {
+			queued->move.dir = directions[turns];
+		}
+		return true;
+	}
+	return send_move_unlimited(move, source);
+}
+
+static struct queued_move shift_moves() {
+	// removes the first move and returns it
+	struct queued_move current = moves.items[moves.head];
+	moves.head = (moves.head + 1) & (moves.capacity - 1);
 
 	--moves.count;
 
@@ -39,91 +116,197 @@ static struct move shift_moves() {
 }
 
 void free_moves() {
-	// frees every item in the linked list
-	while (moves.head) {
+	while (moves.count) {
 		shift_moves();
 	}
-	moves.count = 0;
-	moves.shuffle_count = 0;
+	free(moves.items);
+	reset_moves();
+	free_move_queue(&inbox);
+	free_solve_job(solve_job);
+	solve_job = NULL;
 }
 
-bool send_move_unlimited(struct move move) {
-	// appends the move to the linked list
+bool take_queued_move(struct move *move) {
+	// removes the next move without playing it, so the queue can be checked without a window
+	if (!moves.count) return false;
+	*move = shift_moves().move;
+	return true;
+}
 
-	struct move_list_item *current = malloc(sizeof(struct move_list_item));
-	if (!current) {
-		warn("Failed to allocate memory for the move");
-		return false;
-	}
-	current->item = move;
-	current->next = NULL;
+bool send_move_unlimited(struct move move, enum move_source source) {
+	// appends the move to the end of the ring buffer
+	if (moves.count == moves.capacity && !grow_moves()) return false;
+	moves.items[(moves.head + moves.count) & (moves.capacity - 1)] = (struct queued_move){move, source};
 	++moves.count;
-	if (moves.tail) {
-		moves.tail->next = current;
-	} else {
-		moves.head = current;
-	}
-	moves.tail = current;
 	return true;
 }
 
-bool send_move(struct move move) {
-	if (moves.count >= max_moves) {
-		// max moves at a time
-		return true;
+enum send_result send_move(struct move move, enum move_source source) {
+	// only called from the thread that runs update_moves, a long queue makes the turns faster instead of dropping moves
+	return queue_move(move, source) ? SEND_OK : SEND_FAILED;
+}
+
+enum send_result post_move(struct move move) {
+	// can be called from any thread, update_moves queues the move on the next frame as a script move
+	// the move can come from anywhere, so it is checked here where the producer still gets the error
+	if (get_move_index(move) < 0) {
+		warnx("Invalid move with face %d and direction %d", move.face, move.dir);
+		return SEND_FAILED;
 	}
+	return push_move_queue(&inbox, move) ? SEND_OK : SEND_FULL;
+}
 
-	return send_move_unlimited(move);
+// rotations the shader is turning, or has turned, in each of its slots
+static struct sticker_rotations turning[ANIMATION_SLOTS];
+
+static int find_animation_slot(uint64_t stickers, int_time current_time) {
+	// a move can only turn while no turning rotation shares a sticker with it, then both turn independently
+	int slot = -1;
+	for (int i = 0; i < ANIMATION_SLOTS; ++i) {
+		if (current_time >= turning[i].start_time + turning[i].turn_time) {
+			if (slot < 0) slot = i;
+		} else if (turning[i].stickers & stickers) {
+			return -1;
+		}
+	}
+	return slot;
 }
 
-static int_time last_moved = 0;
+static bool stop_animations(int_time current_time) {
+	// moves with no turn time change stickers under the rotations, so those are finished early
+	for (int i = 0; i < ANIMATION_SLOTS; ++i) {
+		if (current_time >= turning[i].start_time + turning[i].turn_time) continue;
+		turning[i].turn_time = 0;
+		if (!send_animation(i, turning[i])) return false;
+	}
+	return true;
+}
 
 bool update_moves(int_time current_time, struct cube *cube) {
-	if (!moves.head) return true;
-	if (current_time <= last_moved) return true;
+	struct move posted;
+	while (pop_move_queue(&inbox, &posted)) {
+		if (!queue_move(posted, SOURCE_SCRIPT)) return false;
+	}
 
-	last_moved = current_time + current_turn_time;
-	struct sticker_rotations animation;
-	make_move(cube, shift_moves(), &animation);
-	animation.start_time = current_time;
+	// the turn time follows the length of the queue when each move starts, and moves with no turn time do not animate
+	// moves that share no stickers with the ones turning, like R L, start while they are still turning
+	bool moved = false;
+	for (size_t applied = 0; moves.count && applied < MAX_INSTANT_MOVES; ++applied) {
+		update_turn_time();
+		if (current_turn_time == 0) {
+			if (!stop_animations(current_time)) return false;
+			struct queued_move queued = shift_moves();
+			make_move(cube, queued.move, NULL);
+			record_move(queued.move, queued.source);
+			moved = true;
+			continue;
+		}
+
+		// queue_move and post_move turn away invalid moves, but send_move_unlimited trusts its caller
+		const struct sticker_rotations *next = get_move_animation(get_queued_move(0)->move);
+		if (!next) {
+			struct move invalid = shift_moves().move;
+			warnx("Skipped invalid move with face %d and direction %d", invalid.face, invalid.dir);
+			continue;
+		}
+		int slot = find_animation_slot(next->stickers, current_time);
+		if (slot < 0) break;
+		struct sticker_rotations *animation = &turning[slot];
+		struct queued_move queued = shift_moves();
+		make_move(cube, queued.move, animation);
+		record_move(queued.move, queued.source);
+		animation->start_time = current_time;
+		animation->turn_time = current_turn_time;
+		if (!send_animation(slot, *animation)) return false;
+		moved = true;
+	}
 
+	if (!moved) return true;
+	flush_recording();
 	if (!update_cube(cube)) return false;
-	if (!send_animation(animation)) return false;
 
 	return true;
 }
 
+static int_time get_turn_time() {
+	// shuffles and solutions keep their own speed
+	if (moves.shuffle_count > 0) return turn_time_shuffle;
+	// past adaptive_queue_depth each turn gets shorter, so the queue plays in about the same time however long it is
+	if (moves.count <= adaptive_queue_depth) return turn_time;
+	if (moves.count >= instant_queue_depth) return 0;
+	return turn_time * adaptive_queue_depth / moves.count;
+}
+
 void update_turn_time() {
-	current_turn_time = moves.shuffle_count > 0 ? turn_time_shuffle : turn_time;
-	update_render_turn_time();
+	// each animation takes the turn time it started with, so the shader does not need to know it
+	current_turn_time = get_turn_time();
 }
 
 bool shuffle_cube(struct cube *cube) {
-	static bool set_seed = false;
-	if (!set_seed) {
-		srand(time(NULL));
-		set_seed = true;
+	// don't shuffle if already moving or solving
+	if (moves.count != 0 || solve_job) return true;
+	static struct random random;
+	static bool seeded = false;
+	if (!seeded) {
+		seed_random(&random, get_random_seed());
+		seeded = true;
 	}
-	const enum move_face possible_faces[] = {U, R, F, D, L, B};
-	const size_t possible_faces_count = sizeof(possible_faces) / sizeof(possible_faces[0]);
-	const enum move_face possible_dirs[] = {cw, ccw, dbl};
-	const size_t possible_dirs_count = sizeof(possible_dirs) / sizeof(possible_dirs[0]);
-	if (moves.count != 0) return true;
-	enum move_face second_last_move = 0;
-	enum move_face last_move = 0;
-	// don't shuffle if already moving
-	for (size_t times = 0; times < 20; ++times) {
-		struct move move;
-		do {
-			move.face = possible_faces[rand() % possible_faces_count];
-		} while (move.face == last_move || (move.face == second_last_move && last_move == FLIP_FACE(second_last_move))); // prevent undoing the move
-		move.dir = possible_dirs[rand() % possible_dirs_count];
-		second_last_move = last_move;
-		last_move = move.face;
-		if (!send_move_unlimited(move)) return false;
+
+	// a solution of a random state after the cube takes the cube to the inverse of that state, which is just as random
+	struct cubie_cube current, state, target_cubie;
+	enum cubie_error error = cube_to_cubie(cube, &current);
+	if (error != CUBIE_OK) {
+		warnx("Cannot shuffle cube: %s", get_cubie_error_string(error));
+		return true;
+	}
+	get_random_cubie(&random, &state);
+	multiply_cubie(&target_cubie, &state, &current);
+	struct cube target;
+	cubie_to_cube(&target_cubie, &target);
+
+	// update_solution queues the moves once they are found, and plays them as fast as a solution
+	struct solve_options options = get_default_solve_options();
+	solve_job = start_solve_job(&target, &options);
+	if (!solve_job) return false;
+	solve_start = *cube;
+	solve_source = SOURCE_SHUFFLE;
+	return true;
+}
+
+bool queue_solution(struct cube *cube) {
+	// don't solve if already moving or solving, the queued moves would change the cube
+	if (moves.count != 0 || solve_job) return true;
+
+	// search in the background so the window keeps drawing, update_solution queues the result
+	struct solve_options options = get_default_solve_options();
+	solve_job = start_solve_job(cube, &options);
+	if (!solve_job) return false;
+	solve_start = *cube;
+	solve_source = SOURCE_SOLUTION;
+	return true;
+}
+
+bool update_solution(struct cube *cube) {
+	// called every frame, queues the best solution once the search is done
+	if (!solve_job || !is_solve_job_done(solve_job)) return true;
+
+	struct solution solution;
+	bool found = poll_solve_job(solve_job, &solution);
+	enum cubie_error error = get_solve_job_error(solve_job);
+	free_solve_job(solve_job);
+	solve_job = NULL;
+	if (error != CUBIE_OK) {
+		warnx("Cannot solve cube: %s", get_cubie_error_string(error));
+		return true;
+	}
+	// the solution is useless if the cube was turned in the meantime
+	if (!found || moves.count != 0 || memcmp(cube, &solve_start, sizeof(struct cube)) != 0) return true;
+
+	for (size_t i = 0; i < solution.length; ++i) {
+		if (!send_move_unlimited(solution.moves[i], solve_source)) return false;
 	}
+	// play the solution as fast as a shuffle
 	moves.shuffle_count = moves.count;
-	// update speed for turning
 	update_turn_time();
 	return true;
 }
@@ -2,22 +2,37 @@
 #define MOVES_H
 #include "config.h"
 #include <stdbool.h>
+#include "record.h"
 #include "rubik.h"
-// linked list
+struct queued_move {
+	struct move move;
+	enum move_source source;
+};
+// ring buffer of queued moves, it only grows so queueing a move does not allocate once it is large enough
 struct move_list {
-	struct move_list_item {
-		struct move item;
-		struct move_list_item *next;
-	} *head, *tail;
+	struct queued_move *items;
+	size_t capacity; // always a power of two, or 0 before the first move
+	size_t head;     // index of the first move
 	size_t count, last_shuffle_count, shuffle_count;
 };
+// result of queueing a move
+enum send_result {
+	SEND_OK,
+	SEND_FULL,   // no room for the move right now, it was not queued and can be sent again later
+	SEND_FAILED, // an error that was already reported, like running out of memory
+};
+
 extern struct move_list moves;
 extern int_time current_turn_time;
-void init_moves();
+bool init_moves();
 void free_moves();
-bool send_move_unlimited(struct move move);
-bool send_move(struct move move);
+bool send_move_unlimited(struct move move, enum move_source source);
+enum send_result send_move(struct move move, enum move_source source);
+enum send_result post_move(struct move move);
 bool update_moves(int_time current_time, struct cube *cube);
 bool shuffle_cube(struct cube *);
+bool queue_solution(struct cube *cube);
+bool update_solution(struct cube *cube);
 void update_turn_time();
+bool take_queued_move(struct move *move);
 #endif
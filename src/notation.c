@@ -0,0 +1,222 @@
+#include <ctype.h>
+#include <string.h>
+#include "notation.h"
+#include "err.h"
+
+// characters that separate moves
+static const bool separators[256] = {[' '] = true, ['\t'] = true, ['\n'] = true, ['\v'] = true, ['\f'] = true, ['\r'] = true};
+// characters that start a move, and the faces that can be followed by w
+static const bool face_chars[256] = {
+        ['U'] = true, ['R'] = true, ['F'] = true, ['D'] = true, ['L'] = true, ['B'] = true,
+        ['u'] = true, ['r'] = true, ['f'] = true, ['d'] = true, ['l'] = true, ['b'] = true,
+        ['M'] = true, ['E'] = true, ['S'] = true, ['x'] = true, ['y'] = true, ['z'] = true,
+};
+// direction and length of the character after a face
+static const enum move_direction suffix_dirs[256] = {['2'] = dbl, ['\''] = ccw};
+static const uint8_t suffix_lengths[256] = {['2'] = 1, ['\''] = 1};
+static const bool wide_chars[256] = {['U'] = true, ['R'] = true, ['F'] = true, ['D'] = true, ['L'] = true, ['B'] = true};
+
+size_t parse_moves_chunk(const char *text, size_t length, bool final, struct move *moves, size_t max_count, size_t *consumed, size_t *error) {
+	// reads moves like "R U2 r' Rw M x2" until the text ends, moves is full or a move is invalid
+	// without final, a move that touches the end of the text is left for the next chunk, since it might go on
+	const unsigned char *c = (const unsigned char *) text;
+	size_t count = 0, i = 0;
+	*error = NOTATION_NO_ERROR;
+	while (i < length) {
+		if (separators[c[i]]) {
+			++i;
+			continue;
+		}
+		if (!face_chars[c[i]]) {
+			*error = i;
+			break;
+		}
+
+		size_t start = i++;
+		struct move move = {.face = c[start], .dir = cw};
+		if (i + 4 <= length) {
+			// the common case, with room for the longest move and a separator after it, so no length checks
+			if (c[i] == 'w' && wide_chars[c[start]]) {
+				move.face = move.face - U + u;
+				++i;
+			}
+			move.dir = suffix_dirs[c[i]];
+			i += suffix_lengths[c[i]];
+			if (move.dir == dbl && c[i] == '\'') ++i;
+			if (!separators[c[i]]) {
+				*error = i;
+				break;
+			}
+			if (count == max_count) {
+				i = start;
+				break;
+			}
+			moves[count++] = move;
+			continue;
+		}
+
+		// Rw is the same as r
+		if (i < length && c[i] == 'w' && wide_chars[c[start]]) {
+			move.face = move.face - U + u;
+			++i;
+		}
+		if (i < length && c[i] == '2') {
+			move.dir = dbl;
+			++i;
+			if (i < length && c[i] == '\'') ++i; // R2' is the same as R2
+		} else if (i < length && c[i] == '\'') {
+			move.dir = ccw;
+			++i;
+		}
+
+		if (i == length && !final) {
+			i = start;
+			break;
+		}
+		if (i < length && !separators[c[i]]) {
+			*error = i;
+			break;
+		}
+		if (count == max_count) {
+			i = start;
+			break;
+		}
+		moves[count++] = move;
+	}
+	*consumed = i;
+	return count;
+}
+
+bool parse_moves(const char *text, struct move *moves, size_t max_count, size_t *count) {
+	// parses moves separated by whitespace, reporting the first invalid one
+	size_t length = strlen(text), consumed, error;
+	*count = parse_moves_chunk(text, length, true, moves, max_count, &consumed, &error);
+	if (error != NOTATION_NO_ERROR) {
+		size_t start = error;
+		while (start > 0 && !separators[(unsigned char) text[start - 1]]) --start;
+		if (start == error) {
+			warnx("Invalid move '%c' at position %zu", text[error], error + 1);
+		} else {
+			warnx("Invalid move '%.*s' at position %zu", (int) (error - start + 1), text + start, start + 1);
+		}
+		return false;
+	}
+	if (consumed < length) {
+		warnx("Too many moves, at most %zu are allowed", max_count);
+		return false;
+	}
+	return true;
+}
+
+size_t format_moves(const struct move *moves, size_t count, char *buffer, size_t size) {
+	// writes moves separated by spaces, returns the length it needs like snprintf
+	// every move takes at most 3 characters with its space, so most buffers can be written without checking the size
+	if (count == 0 || count * 3 < size) {
+		char *end = buffer;
+		for (size_t i = 0; i < count; ++i) {
+			*end = ' ';
+			end += i > 0;
+			*end++ = get_char_move_face(moves[i].face);
+			*end = get_char_move_direction(moves[i].dir);
+			end += moves[i].dir != cw;
+		}
+		if (size) *end = '\0';
+		return end - buffer;
+	}
+
+	size_t length = 0;
+	for (size_t i = 0; i < count; ++i) {
+		char move[3];
+		size_t move_length = 0;
+		if (i > 0) move[move_length++] = ' ';
+		move[move_length++] = get_char_move_face(moves[i].face);
+		char dir = get_char_move_direction(moves[i].dir);
+		if (dir) move[move_length++] = dir;
+
+		for (size_t j = 0; j < move_length; ++j, ++length) {
+			if (length + 1 < size) buffer[length] = move[j];
+		}
+	}
+	if (size) buffer[length < size ? length : size - 1] = '\0';
+	return length;
+}
+
+bool parse_move_set(const char *text, enum move_face *faces, size_t *count) {
+	// move faces like "RU", "<R,U,F>" or "M U", faces has room for MOVE_FACE_COUNT
+	*count = 0;
+	for (const char *c = text; *c; ++c) {
+		if (isspace((unsigned char) *c) || strchr("<>,", *c)) continue;
+
+		enum move_face face = *c;
+		if (get_move_index((struct move){.face = face, .dir = cw}) < 0) {
+			warnx("Invalid move face '%c' at position %zu", *c, (size_t) (c - text) + 1);
+			return false;
+		}
+		// Rw is the same as r
+		if (c[1] == 'w' && strchr("URFDLB", face)) {
+			face = face - U + u;
+			++c;
+		}
+		for (size_t i = 0; i < *count; ++i) {
+			if (faces[i] != face) continue;
+			warnx("Move face '%c' is in the move set twice", face);
+			return false;
+		}
+		faces[(*count)++] = face;
+	}
+	if (*count == 0) {
+		warnx("Move set is empty");
+		return false;
+	}
+	return true;
+}
+
+// faces of the facelet string in order, U R F D L B
+static const intpos facelet_faces[6] = {0, 2, 1, 5, 4, 3};
+
+bool is_facelet_string(const char *text) {
+	// 54 characters without any spaces, which can never be a list of moves
+	size_t length = 0;
+	for (; text[length]; ++length) {
+		if (isspace((unsigned char) text[length])) return false;
+	}
+	return length == 9 * 6;
+}
+
+bool parse_facelets(const char *text, struct cube *cube) {
+	// each face is read row by row like the net in Kociemba's solver, such as "UUUUUUUUURRRRRRRRRFFFFFFFFFDDDDDDDDDLLLLLLLLLBBBBBBBBB"
+	if (!is_facelet_string(text)) {
+		warnx("Facelet string must be 54 characters without spaces");
+		return false;
+	}
+
+	// any six characters can be used, the centers decide which face each one stands for
+	char centers[6];
+	for (intpos i = 0; i < 6; ++i) {
+		centers[i] = text[i * 9 + 4];
+		if (memchr(centers, centers[i], i)) {
+			warnx("Duplicate center '%c' at position %d", centers[i], i * 9 + 5);
+			return false;
+		}
+	}
+
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		const char *center = memchr(centers, text[i], 6);
+		if (!center) {
+			warnx("Invalid facelet '%c' at position %d, it does not match any center", text[i], i + 1);
+			return false;
+		}
+		cube->faces[facelet_faces[i / 9]].stickers[i % 9] = facelet_faces[center - centers];
+	}
+	return true;
+}
+
+void format_facelets(const struct cube *cube, char *buffer) {
+	// the same order parse_facelets reads, each color named after the face its center is on
+	static const char facelet_names[6] = {'U', 'R', 'F', 'D', 'L', 'B'};
+	char names[256];
+	memset(names, '?', sizeof(names));
+	for (intpos i = 0; i < 6; ++i) names[cube->faces[facelet_faces[i]].stickers[4]] = facelet_names[i];
+	for (intpos i = 0; i < 9 * 6; ++i) buffer[i] = names[cube->faces[facelet_faces[i / 9]].stickers[i % 9]];
+	buffer[9 * 6] = '\0';
+}
@@ -0,0 +1,18 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+#include <stddef.h>
+#include <stdint.h>
+#include "rubik.h"
+
+// error offset of parse_moves_chunk when every move was valid
+#define NOTATION_NO_ERROR SIZE_MAX
+
+size_t parse_moves_chunk(const char *text, size_t length, bool final, struct move *moves, size_t max_count, size_t *consumed, size_t *error);
+bool parse_moves(const char *text, struct move *moves, size_t max_count, size_t *count);
+size_t format_moves(const struct move *moves, size_t count, char *buffer, size_t size);
+bool parse_move_set(const char *text, enum move_face *faces, size_t *count);
+bool is_facelet_string(const char *text);
+bool parse_facelets(const char *text, struct cube *cube);
+// writes 54 facelets and a null terminator
+void format_facelets(const struct cube *cube, char *buffer);
+#endif //NOTATION_H
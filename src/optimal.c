@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "optimal.h"
+#include "coord.h"
+#include "err.h"
+#include "util.h"
+#include "table_file.h"
+#include "random.h"
+
+// pattern databases store the distance of every index to the solved state, two indices per byte
+// the corner database is indexed by corners * TWIST_COUNT + twist
+// an edge database is indexed by the positions and orientations of some edge pieces, see get_edge_set_index
+
+#define PATTERN_UNKNOWN 15
+#define CORNER_PATTERN_SIZE ((uint32_t) CORNERS_COUNT * TWIST_COUNT)
+
+#define CORNER_PATTERN_FILE_NAME "optimal-corners.tbl"
+#define EDGE_PATTERN_FILE_NAME "optimal-edges-%d.tbl"
+// change this whenever the pattern databases are built differently
+#define PATTERN_TABLES_VERSION 1
+// how often the search checks whether it was cancelled
+#define CANCEL_CHECK_NODES 65536
+// most nodes are close to the leaves, where a probe of the transposition table costs more than the search it saves
+#define TRANSPOSITION_MIN_TOGO 8
+
+static struct table_file corner_pattern_file, edge_pattern_file;
+static const uint8_t *corner_pattern = NULL;
+// the first database tracks the first pattern_edges pieces, the second the last ones
+static const uint8_t *edge_pattern[2] = {NULL, NULL};
+static int loaded_pattern_edges = 0;
+
+// every solve shares this table, an entry is a lower bound on the distance of a state to the solved state
+static struct transposition_table transpositions;
+static bool has_transpositions = false, transpositions_set_up = false;
+static int transposition_mb;
+static enum replacement_policy transposition_policy;
+
+// edge pieces are stored as position * 2 + orientation, this maps them to where a move takes them
+static uint8_t edge_piece_move[CUBIE_MOVE_COUNT][24];
+
+struct pattern_database {
+	uint32_t size;
+	uint32_t solved_index;
+	void (*get_neighbors)(uint32_t index, uint32_t *neighbors, const struct pattern_database *database);
+	int first_edge, edge_count;
+};
+
+static uint8_t get_nibble(const uint8_t *table, uint32_t index) {
+	return table[index >> 1] >> (index & 1) * 4 & 15;
+}
+
+static void set_nibble(uint8_t *table, uint32_t index, uint8_t value) {
+	int shift = (index & 1) * 4;
+	table[index >> 1] = (table[index >> 1] & ~(15 << shift)) | value << shift;
+}
+
+static uint32_t get_edge_pattern_size(int edge_count) {
+	// 12 * 11 * ... positions for the pieces, times two orientations each
+	uint32_t size = 1;
+	for (int i = 0; i < edge_count; ++i) size *= 12 - i;
+	return size << edge_count;
+}
+
+static uint32_t get_edge_set_index(const uint8_t *pieces, int count) {
+	// positions ranked like a partial permutation, followed by one orientation bit per piece
+	uint32_t rank = 0, orientation = 0;
+	uint16_t used = 0;
+	for (int i = 0; i < count; ++i) {
+		int position = pieces[i] >> 1;
+		rank = rank * (12 - i) + position - __builtin_popcount(used & ((1u << position) - 1));
+		used |= 1u << position;
+		orientation = orientation << 1 | (pieces[i] & 1);
+	}
+	return rank << count | orientation;
+}
+
+static void set_edge_set_index(uint8_t *pieces, int count, uint32_t index) {
+	uint32_t orientation = index & ((1u << count) - 1), rank = index >> count;
+	int digits[MAX_PATTERN_EDGES];
+	for (int i = count; i-- > 0;) {
+		digits[i] = rank % (12 - i);
+		rank /= 12 - i;
+	}
+
+	uint16_t used = 0;
+	for (int i = 0; i < count; ++i) {
+		// the digit-th position that is still free
+		int position = 0;
+		for (int skip = digits[i];; ++position) {
+			if (used & (1u << position)) continue;
+			if (skip-- == 0) break;
+		}
+		used |= 1u << position;
+		pieces[i] = position << 1 | (orientation >> (count - 1 - i) & 1);
+	}
+}
+
+static void get_corner_neighbors(uint32_t index, uint32_t *neighbors, const struct pattern_database *database) {
+	uint32_t corners = index / TWIST_COUNT, twist = index % TWIST_COUNT;
+	for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+		neighbors[move] = corners_move[corners][move] * TWIST_COUNT + twist_move[twist][move];
+	}
+}
+
+static void get_edge_neighbors(uint32_t index, uint32_t *neighbors, const struct pattern_database *database) {
+	uint8_t pieces[MAX_PATTERN_EDGES], moved[MAX_PATTERN_EDGES];
+	set_edge_set_index(pieces, database->edge_count, index);
+	for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+		for (int i = 0; i < database->edge_count; ++i) moved[i] = edge_piece_move[move][pieces[i]];
+		neighbors[move] = get_edge_set_index(moved, database->edge_count);
+	}
+}
+
+// breadth first search from the solved state
+static void build_pattern_database(uint8_t *table, const struct pattern_database *database) {
+	memset(table, PATTERN_UNKNOWN << 4 | PATTERN_UNKNOWN, (database->size + 1) / 2);
+	set_nibble(table, database->solved_index, 0);
+
+	uint32_t neighbors[CUBIE_MOVE_COUNT];
+	uint32_t filled = 1, level = 1;
+	for (uint8_t depth = 0; level && depth + 1 < PATTERN_UNKNOWN; ++depth) {
+		// once the last level outgrows the unknown indices, it is faster to look for a neighbor in the last level from each unknown index
+		bool backward = level > database->size - filled;
+		level = 0;
+		for (uint32_t index = 0; index < database->size; ++index) {
+			uint8_t distance = get_nibble(table, index);
+			if (backward) {
+				if (distance != PATTERN_UNKNOWN) continue;
+				database->get_neighbors(index, neighbors, database);
+				for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+					if (get_nibble(table, neighbors[move]) != depth) continue;
+					set_nibble(table, index, depth + 1);
+					++level;
+					break;
+				}
+			} else {
+				if (distance != depth) continue;
+				database->get_neighbors(index, neighbors, database);
+				for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+					if (get_nibble(table, neighbors[move]) != PATTERN_UNKNOWN) continue;
+					set_nibble(table, neighbors[move], depth + 1);
+					++level;
+				}
+			}
+		}
+		filled += level;
+	}
+}
+
+static bool build_corner_pattern(void *data, size_t size, void *userdata) {
+	struct pattern_database database = {
+	        .size = CORNER_PATTERN_SIZE,
+	        .solved_index = 0,
+	        .get_neighbors = get_corner_neighbors,
+	};
+	build_pattern_database(data, &database);
+	return true;
+}
+
+static bool build_edge_patterns(void *data, size_t size, void *userdata) {
+	int edge_count = *(int *) userdata;
+	uint8_t *table = data;
+	for (int i = 0; i < 2; ++i) {
+		struct pattern_database database = {
+		        .size = get_edge_pattern_size(edge_count),
+		        .get_neighbors = get_edge_neighbors,
+		        .first_edge = i == 0 ? 0 : 12 - edge_count,
+		        .edge_count = edge_count,
+		};
+		uint8_t solved[MAX_PATTERN_EDGES] = {0};
+		for (int j = 0; j < edge_count; ++j) solved[j] = (database.first_edge + j) << 1;
+		database.solved_index = get_edge_set_index(solved, edge_count);
+
+		build_pattern_database(table, &database);
+		table += (database.size + 1) / 2;
+	}
+	return true;
+}
+
+static void init_edge_piece_moves() {
+	for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+		// each piece of a solved cube starts in the position of its number, so the move shows where each position goes
+		const struct cubie_cube *cube = get_cubie_move(move);
+		for (int position = 0; position < 12; ++position) {
+			int from = EDGE_PIECE(cube->edges[position]), flip = EDGE_ORIENTATION(cube->edges[position]);
+			for (int orientation = 0; orientation < 2; ++orientation) {
+				edge_piece_move[move][from << 1 | orientation] = position << 1 | (orientation ^ flip);
+			}
+		}
+	}
+}
+
+static void init_transpositions(int megabytes, enum replacement_policy policy) {
+	if (transpositions_set_up && transposition_mb == megabytes && transposition_policy == policy) return;
+	if (has_transpositions) free_transposition_table(&transpositions);
+	// the search still works without the table, just slower
+	has_transpositions = megabytes > 0 && init_transposition_table(&transpositions, megabytes, policy);
+	transpositions_set_up = true;
+	transposition_mb = megabytes;
+	transposition_policy = policy;
+}
+
+void init_optimal_solver(const struct solve_options *options) {
+	int pattern_edges = options->pattern_edges;
+	if (pattern_edges < MIN_PATTERN_EDGES || pattern_edges > MAX_PATTERN_EDGES) {
+		errx(1, "Pattern databases need between %d and %d edges", MIN_PATTERN_EDGES, MAX_PATTERN_EDGES);
+	}
+	init_transpositions(options->transposition_mb, options->replacement);
+	if (loaded_pattern_edges == pattern_edges) return;
+	init_coord_tables();
+	init_edge_piece_moves();
+
+	// the databases are built from the move tables, so they share their key
+	uint64_t key = get_coord_tables_key() ^ PATTERN_TABLES_VERSION << 8;
+	if (!corner_pattern) {
+		if (!load_table_file(CORNER_PATTERN_FILE_NAME, key, (CORNER_PATTERN_SIZE + 1) / 2, build_corner_pattern, NULL, &corner_pattern_file)) {
+			errx(1, "Failed to load corner pattern database");
+		}
+		corner_pattern = corner_pattern_file.data;
+	}
+
+	if (loaded_pattern_edges) unload_table_file(&edge_pattern_file);
+	char name[64];
+	snprintf(name, sizeof(name), EDGE_PATTERN_FILE_NAME, pattern_edges);
+	size_t size = (get_edge_pattern_size(pattern_edges) + 1) / 2;
+	if (!load_table_file(name, key ^ pattern_edges, size * 2, build_edge_patterns, &pattern_edges, &edge_pattern_file)) {
+		errx(1, "Failed to load edge pattern databases");
+	}
+	edge_pattern[0] = edge_pattern_file.data;
+	edge_pattern[1] = edge_pattern[0] + size;
+	loaded_pattern_edges = pattern_edges;
+}
+
+struct optimal_search {
+	int pattern_edges;
+	atomic_bool *cancel;
+	bool cancelled;
+	int path[MAX_OPTIMAL_LENGTH];
+	uint64_t nodes;
+};
+
+static bool is_edges_solved(const uint8_t *edges) {
+	for (int i = 0; i < 12; ++i) {
+		if (edges[i] != i << 1) return false;
+	}
+	return true;
+}
+
+// the face of the previous move is part of the key, since it limits which moves the search tries next
+static struct cube_hash get_search_hash(uint16_t corners, uint16_t twist, const uint8_t *edges, int previous) {
+	// the key fits in 91 bits and splitmix64 maps each half to a different value, so no two keys share a hash
+	uint64_t face = previous < 0 ? 0 : previous / 3 + 1;
+	uint64_t low = twist & 15, high = face << 24 | (uint64_t) corners << 8 | twist >> 4;
+	for (int i = 0; i < 12; ++i) low = low << 5 | edges[i];
+	return (struct cube_hash){.low = splitmix64(&low), .high = splitmix64(&high)};
+}
+
+// edges holds each edge piece as position * 2 + orientation
+// returns at most togo with the solution in path, or else a lower bound on the moves the state needs
+// that bound only counts sequences starting with a move allowed after the previous face, as the search does
+static int search_optimal(struct optimal_search *search, uint16_t corners, uint16_t twist, const uint8_t *edges, int depth, int togo) {
+	if (++search->nodes % CANCEL_CHECK_NODES == 0 && search->cancel && atomic_load(search->cancel)) search->cancelled = true;
+	if (search->cancelled) return togo + 1;
+	int pattern_edges = search->pattern_edges, estimate;
+	if ((estimate = get_nibble(corner_pattern, (uint32_t) corners * TWIST_COUNT + twist)) > togo) return estimate;
+	if ((estimate = get_nibble(edge_pattern[0], get_edge_set_index(edges, pattern_edges))) > togo) return estimate;
+	if ((estimate = get_nibble(edge_pattern[1], get_edge_set_index(edges + 12 - pattern_edges, pattern_edges))) > togo) return estimate;
+	// with fewer than 6 edges per database, some edges are not covered by either of them
+	// the solved state never comes up with moves to go, it would have been found by an earlier iteration
+	if (togo == 0) return corners == 0 && twist == 0 && is_edges_solved(edges) ? 0 : 1;
+
+	int previous = depth > 0 ? search->path[depth - 1] : -1;
+	bool use_table = has_transpositions && togo >= TRANSPOSITION_MIN_TOGO;
+	struct cube_hash hash;
+	if (use_table) {
+		hash = get_search_hash(corners, twist, edges, previous);
+		uint32_t bound;
+		uint8_t depth_searched;
+		if (probe_transposition(&transpositions, hash, &bound, &depth_searched) && bound > (uint32_t) togo) return bound;
+	}
+
+	uint8_t next_edges[12];
+	int bound = MAX_OPTIMAL_LENGTH + 1;
+	for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+		if (!is_canonical_move(move, previous)) continue;
+		for (int i = 0; i < 12; ++i) next_edges[i] = edge_piece_move[move][edges[i]];
+		search->path[depth] = move;
+		int needed = search_optimal(search, corners_move[corners][move], twist_move[twist][move], next_edges, depth + 1, togo - 1) + 1;
+		if (needed <= togo) return needed;
+		if (needed < bound) bound = needed;
+	}
+	// the bound is a fact about the state, so it holds for whichever solve or thread gets here next after the same face
+	// a cancelled search did not try every move
+	if (use_table && !search->cancelled) store_transposition(&transpositions, hash, bound, togo);
+	return bound;
+}
+
+enum cubie_error solve_optimal(const struct cubie_cube *cube, const struct solve_options *options, struct solution *solution) {
+	enum cubie_error error = verify_cubie(cube);
+	if (error != CUBIE_OK) return error;
+	init_optimal_solver(options);
+	if (has_transpositions) next_transposition_generation(&transpositions);
+
+	uint64_t start = get_time_ns();
+	struct optimal_search search = {.pattern_edges = options->pattern_edges, .cancel = options->cancel, .cancelled = false, .nodes = 0};
+	uint8_t edges[12];
+	for (int position = 0; position < 12; ++position) {
+		edges[EDGE_PIECE(cube->edges[position])] = position << 1 | EDGE_ORIENTATION(cube->edges[position]);
+	}
+	uint16_t corners = get_corners(cube), twist = get_twist(cube);
+
+	// iterative deepening, so the first solution found is a shortest one
+	// a failed iteration proves a lower bound on the length, the next one starts there
+	solution->length = 0;
+	for (int length = 0, bound; length <= MAX_OPTIMAL_LENGTH && !search.cancelled; length = bound) {
+		bound = search_optimal(&search, corners, twist, edges, 0, length);
+		if (bound > length) continue;
+		for (int i = 0; i < length; ++i) {
+			solution->moves[i].face = move_faces[search.path[i] / 3];
+			solution->moves[i].dir = search.path[i] % 3;
+		}
+		solution->length = length;
+		solution->time_ns = get_time_ns() - start;
+		solution->nodes = search.nodes;
+		if (options->on_solution) options->on_solution(solution, options->userdata);
+		break;
+	}
+	solution->time_ns = get_time_ns() - start;
+	solution->nodes = search.nodes;
+	return CUBIE_OK;
+}
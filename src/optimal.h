@@ -0,0 +1,23 @@
+#ifndef OPTIMAL_H
+#define OPTIMAL_H
+#include "solver.h"
+
+// optimal solver, finds a shortest solution with iterative deepening A*
+// the distance estimate is the largest of a corner pattern database and two edge pattern databases
+
+// edges in each edge pattern database, every extra edge makes them 12 - edges times larger and the search faster
+#define MIN_PATTERN_EDGES 5
+#define MAX_PATTERN_EDGES 7
+#define DEFAULT_PATTERN_EDGES 6
+
+// size of the transposition table, it keeps lower bounds on the distance of states the search already went through
+#define DEFAULT_TRANSPOSITION_MB 64
+
+// longest optimal solution, God's number in the face turn metric
+#define MAX_OPTIMAL_LENGTH 20
+
+// loads the pattern databases and sets up the transposition table, call it before solving from several threads
+void init_optimal_solver(const struct solve_options *options);
+// uses pattern_edges, transposition_mb, replacement, on_solution and cancel from options
+enum cubie_error solve_optimal(const struct cubie_cube *cube, const struct solve_options *options, struct solution *solution);
+#endif //OPTIMAL_H
@@ -0,0 +1,288 @@
+#include <string.h>
+#include "pack.h"
+#include "coord.h"
+
+#define NO_PIECE 0xff
+
+static intpos corner_stickers[8][3];
+static intpos edge_stickers[12][2];
+static face_color corner_colors[8][3]; // colors of each corner piece when it is solved
+static face_color edge_colors[12][2];
+// colors on the stickers of a position holding a piece with an orientation, indexed by piece * 3 + orientation or piece * 2 + orientation
+static face_color oriented_corner_colors[8 * 3][3];
+static face_color oriented_edge_colors[12 * 2][2];
+
+// piece and orientation seen from the colors of a position, each color takes 3 bits
+static uint8_t corner_codes[8 * 8 * 8];
+static uint8_t edge_codes[8 * 8];
+static bool pack_init = false;
+
+void init_pack() {
+	if (pack_init) return;
+	pack_init = true;
+
+	for (intpos i = 0; i < 8; ++i) {
+		for (intpos j = 0; j < 3; ++j) {
+			corner_stickers[i][j] = get_corner_sticker(i, j);
+			corner_colors[i][j] = corner_stickers[i][j] / 9;
+		}
+	}
+	for (intpos i = 0; i < 12; ++i) {
+		for (intpos j = 0; j < 2; ++j) {
+			edge_stickers[i][j] = get_edge_sticker(i, j);
+			edge_colors[i][j] = edge_stickers[i][j] / 9;
+		}
+	}
+
+	// a piece with orientation o has its sticker j on the sticker (j + o) of the position, like cubie_to_cube
+	memset(corner_codes, NO_PIECE, sizeof(corner_codes));
+	for (intpos piece = 0; piece < 8; ++piece) {
+		for (intpos orientation = 0; orientation < 3; ++orientation) {
+			const face_color *colors = corner_colors[piece];
+			uint16_t index = colors[(3 - orientation) % 3] << 6 | colors[(4 - orientation) % 3] << 3 | colors[(5 - orientation) % 3];
+			corner_codes[index] = MAKE_CORNER(piece, orientation);
+			for (intpos j = 0; j < 3; ++j) oriented_corner_colors[piece * 3 + orientation][j] = colors[(j + 3 - orientation) % 3];
+		}
+	}
+	memset(edge_codes, NO_PIECE, sizeof(edge_codes));
+	for (intpos piece = 0; piece < 12; ++piece) {
+		for (intpos orientation = 0; orientation < 2; ++orientation) {
+			const face_color *colors = edge_colors[piece];
+			edge_codes[colors[orientation] << 3 | colors[orientation ^ 1]] = MAKE_EDGE(piece, orientation);
+			for (intpos j = 0; j < 2; ++j) oriented_edge_colors[piece * 2 + orientation][j] = colors[j ^ orientation];
+		}
+	}
+}
+
+static bool has_solved_centers(const struct cube *cube) {
+	for (intpos face = 0; face < 6; ++face) {
+		if (cube->faces[face].middle_center != face) return false;
+	}
+	return true;
+}
+
+static void get_cubie_coords(const struct cubie_cube *cubie, struct wide_packed_cube *coords) {
+	uint8_t edges[12];
+	for (intpos i = 0; i < 12; ++i) edges[i] = EDGE_PIECE(cubie->edges[i]);
+	*coords = (struct wide_packed_cube){
+	        .corners = get_corners(cubie),
+	        .twist = get_twist(cubie),
+	        .edges = get_permutation_rank(edges, 12),
+	        .flip = get_flip(cubie),
+	};
+}
+
+static enum cubie_error get_coords(const struct cube *cube, struct wide_packed_cube *coords) {
+	if (!has_solved_centers(cube)) {
+		// rare, so the slower path that relabels the colors is fine
+		struct cubie_cube cubie;
+		enum cubie_error error = cube_to_cubie(cube, &cubie);
+		if (error != CUBIE_OK) return error;
+		get_cubie_coords(&cubie, coords);
+		return CUBIE_OK;
+	}
+
+	// reads the pieces straight from the stickers, ranking the permutations as it goes
+	// the lehmer digit of a piece is how many smaller pieces come after it, and the digits add up to the parity
+	// smaller has 4 bits for each piece, counting the smaller pieces seen so far
+	uint16_t seen = 0;
+	uint64_t smaller = 0;
+	uint32_t corners = 0, twist = 0;
+	intpos twist_sum = 0, corner_parity = 0;
+	for (intpos i = 0; i < 8; ++i) {
+		face_color a = cube->stickers[corner_stickers[i][0]], b = cube->stickers[corner_stickers[i][1]], c = cube->stickers[corner_stickers[i][2]];
+		if ((a | b | c) >= 8) return CUBIE_INVALID_CORNER;
+		uint8_t code = corner_codes[a << 6 | b << 3 | c];
+		if (code == NO_PIECE) return CUBIE_INVALID_CORNER;
+		intpos piece = CORNER_PIECE(code), orientation = CORNER_ORIENTATION(code);
+		if (seen & (1 << piece)) return CUBIE_DUPLICATE_CORNER;
+		intpos digit = piece - (smaller >> (piece * 4) & 15);
+		seen |= 1 << piece;
+		smaller += 0x111111111111ull << (piece * 4) << 4;
+		corners = corners * (8 - i) + digit;
+		corner_parity += digit;
+		if (i < 7) twist = twist * 3 + orientation;
+		twist_sum += orientation;
+	}
+
+	seen = 0;
+	smaller = 0;
+	uint32_t edges = 0, flip = 0;
+	intpos flip_sum = 0, edge_parity = 0;
+	for (intpos i = 0; i < 12; ++i) {
+		face_color a = cube->stickers[edge_stickers[i][0]], b = cube->stickers[edge_stickers[i][1]];
+		if ((a | b) >= 8) return CUBIE_INVALID_EDGE;
+		uint8_t code = edge_codes[a << 3 | b];
+		if (code == NO_PIECE) return CUBIE_INVALID_EDGE;
+		intpos piece = EDGE_PIECE(code), orientation = EDGE_ORIENTATION(code);
+		if (seen & (1 << piece)) return CUBIE_DUPLICATE_EDGE;
+		intpos digit = piece - (smaller >> (piece * 4) & 15);
+		seen |= 1 << piece;
+		smaller += 0x111111111111ull << (piece * 4) << 4;
+		edges = edges * (12 - i) + digit;
+		edge_parity += digit;
+		if (i < 11) flip = flip * 2 + orientation;
+		flip_sum += orientation;
+	}
+
+	if (twist_sum % 3) return CUBIE_TWISTED_CORNER;
+	if (flip_sum % 2) return CUBIE_FLIPPED_EDGE;
+	if ((corner_parity ^ edge_parity) & 1) return CUBIE_PARITY;
+	*coords = (struct wide_packed_cube){.corners = corners, .twist = twist, .edges = edges, .flip = flip};
+	return CUBIE_OK;
+}
+
+static inline intpos unrank_permutation(uint8_t *permutation, intpos count, uint32_t rank) {
+	// like set_permutation_rank, but also returns the parity
+	intpos digits[12], parity = 0;
+	// unrolled, so every division is by a constant and becomes a multiplication
+#pragma GCC unroll 12
+	for (intpos i = count; i-- > 0;) {
+		digits[i] = rank % (count - i);
+		rank /= count - i;
+		parity ^= digits[i] & 1;
+	}
+	// the pieces that are left, 4 bits each in increasing order, the digit picks one and the ones after it move down
+	uint64_t left = 0xba9876543210;
+	for (intpos i = 0; i < count; ++i) {
+		intpos shift = digits[i] * 4;
+		permutation[i] = left >> shift & 15;
+		left = (left & ((1ull << shift) - 1)) | (left >> 4 >> shift << shift);
+	}
+	return parity;
+}
+
+static enum cubie_error set_coords(const struct wide_packed_cube *coords, struct cube *cube) {
+	if (coords->corners >= CORNERS_COUNT || coords->twist >= TWIST_COUNT) return CUBIE_INVALID_CORNER;
+	if (coords->edges >= EDGES_COUNT || coords->flip >= FLIP_COUNT) return CUBIE_INVALID_EDGE;
+
+	uint8_t corners[8], edges[12];
+	intpos corner_parity = unrank_permutation(corners, 8, coords->corners);
+	intpos edge_parity = unrank_permutation(edges, 12, coords->edges);
+	if (corner_parity != edge_parity) return CUBIE_PARITY;
+
+	// the last orientation is not stored, it makes the sum a multiple of 3 or 2, like set_twist and set_flip
+	intpos corner_orientations[8], edge_orientations[12], sum = 0;
+	uint32_t twist = coords->twist, flip = coords->flip;
+	for (intpos i = 7; i-- > 0;) {
+		corner_orientations[i] = twist % 3;
+		twist /= 3;
+		sum += corner_orientations[i];
+	}
+	corner_orientations[7] = (3 - sum % 3) % 3;
+	sum = 0;
+	for (intpos i = 11; i-- > 0;) {
+		edge_orientations[i] = flip & 1;
+		flip >>= 1;
+		sum += edge_orientations[i];
+	}
+	edge_orientations[11] = sum & 1;
+
+	for (intpos face = 0; face < 6; ++face) cube->faces[face].middle_center = face;
+	for (intpos i = 0; i < 8; ++i) {
+		const face_color *colors = oriented_corner_colors[corners[i] * 3 + corner_orientations[i]];
+		for (intpos j = 0; j < 3; ++j) cube->stickers[corner_stickers[i][j]] = colors[j];
+	}
+	for (intpos i = 0; i < 12; ++i) {
+		const face_color *colors = oriented_edge_colors[edges[i] * 2 + edge_orientations[i]];
+		for (intpos j = 0; j < 2; ++j) cube->stickers[edge_stickers[i][j]] = colors[j];
+	}
+	return CUBIE_OK;
+}
+
+static void encode_packed(const struct wide_packed_cube *coords, struct packed_cube *packed) {
+	uint64_t low = coords->corners | (uint64_t) coords->twist << 16 | (uint64_t) coords->edges << 28 | (uint64_t) coords->flip << 57;
+	for (intpos i = 0; i < 8; ++i) packed->bytes[i] = low >> (i * 8);
+	packed->bytes[8] = coords->flip >> 7;
+}
+
+static void decode_packed(const struct packed_cube *packed, struct wide_packed_cube *coords) {
+	uint64_t low = 0;
+	for (intpos i = 0; i < 8; ++i) low |= (uint64_t) packed->bytes[i] << (i * 8);
+	*coords = (struct wide_packed_cube){
+	        .corners = low & 0xffff,
+	        .twist = low >> 16 & 0xfff,
+	        .edges = low >> 28 & 0x1fffffff,
+	        // the top 4 bits of the last byte are never set, so they make the flip too large
+	        .flip = low >> 57 | (uint16_t) packed->bytes[8] << 7,
+	};
+}
+
+enum cubie_error pack_cube(const struct cube *cube, struct packed_cube *packed) {
+	init_pack();
+	struct wide_packed_cube coords;
+	enum cubie_error error = get_coords(cube, &coords);
+	if (error == CUBIE_OK) encode_packed(&coords, packed);
+	return error;
+}
+
+enum cubie_error unpack_cube(const struct packed_cube *packed, struct cube *cube) {
+	init_pack();
+	struct wide_packed_cube coords;
+	decode_packed(packed, &coords);
+	return set_coords(&coords, cube);
+}
+
+enum cubie_error pack_cube_wide(const struct cube *cube, struct wide_packed_cube *packed) {
+	init_pack();
+	return get_coords(cube, packed);
+}
+
+enum cubie_error unpack_cube_wide(const struct wide_packed_cube *packed, struct cube *cube) {
+	init_pack();
+	return set_coords(packed, cube);
+}
+
+// the bulk versions set up the tables once and let the compiler inline the conversions into one loop
+
+enum cubie_error pack_cubes(const struct cube *cubes, struct packed_cube *packed, size_t count, size_t *failed) {
+	init_pack();
+	for (size_t i = 0; i < count; ++i) {
+		struct wide_packed_cube coords;
+		enum cubie_error error = get_coords(&cubes[i], &coords);
+		if (error != CUBIE_OK) {
+			if (failed) *failed = i;
+			return error;
+		}
+		encode_packed(&coords, &packed[i]);
+	}
+	return CUBIE_OK;
+}
+
+enum cubie_error unpack_cubes(const struct packed_cube *packed, struct cube *cubes, size_t count, size_t *failed) {
+	init_pack();
+	for (size_t i = 0; i < count; ++i) {
+		struct wide_packed_cube coords;
+		decode_packed(&packed[i], &coords);
+		enum cubie_error error = set_coords(&coords, &cubes[i]);
+		if (error != CUBIE_OK) {
+			if (failed) *failed = i;
+			return error;
+		}
+	}
+	return CUBIE_OK;
+}
+
+enum cubie_error pack_cubes_wide(const struct cube *cubes, struct wide_packed_cube *packed, size_t count, size_t *failed) {
+	init_pack();
+	for (size_t i = 0; i < count; ++i) {
+		enum cubie_error error = get_coords(&cubes[i], &packed[i]);
+		if (error != CUBIE_OK) {
+			if (failed) *failed = i;
+			return error;
+		}
+	}
+	return CUBIE_OK;
+}
+
+enum cubie_error unpack_cubes_wide(const struct wide_packed_cube *packed, struct cube *cubes, size_t count, size_t *failed) {
+	init_pack();
+	for (size_t i = 0; i < count; ++i) {
+		enum cubie_error error = set_coords(&packed[i], &cubes[i]);
+		if (error != CUBIE_OK) {
+			if (failed) *failed = i;
+			return error;
+		}
+	}
+	return CUBIE_OK;
+}
@@ -0,0 +1,38 @@
+#ifndef PACK_H
+#define PACK_H
+#include <stddef.h>
+#include <stdint.h>
+#include "cubie.h"
+
+// a legal cube stored as its cubie coordinates instead of 54 stickers
+// corners 16 bits, twist 12 bits, edges 29 bits and flip 11 bits, 68 bits in total, little endian
+// packing normalizes the colors and rotation of the cube like cube_to_cubie does
+
+#define PACKED_CUBE_SIZE 9
+#define EDGES_COUNT 479001600 // permutation of all 12 edges
+
+struct packed_cube {
+	uint8_t bytes[PACKED_CUBE_SIZE];
+};
+
+// the same coordinates in whole fields, larger but faster to pack and unpack, and every cube starts on its own 16 bytes
+struct wide_packed_cube {
+	uint16_t corners; // get_corners
+	uint16_t twist;   // get_twist
+	uint32_t edges;   // lehmer code of all 12 edges
+	uint16_t flip;    // get_flip
+	uint8_t padding[6];
+} __attribute__((aligned(16)));
+
+void init_pack();
+enum cubie_error pack_cube(const struct cube *cube, struct packed_cube *packed);
+enum cubie_error unpack_cube(const struct packed_cube *packed, struct cube *cube);
+enum cubie_error pack_cube_wide(const struct cube *cube, struct wide_packed_cube *packed);
+enum cubie_error unpack_cube_wide(const struct wide_packed_cube *packed, struct cube *cube);
+
+// many cubes at once, stop at the first one that fails and set failed to its index
+enum cubie_error pack_cubes(const struct cube *cubes, struct packed_cube *packed, size_t count, size_t *failed);
+enum cubie_error unpack_cubes(const struct packed_cube *packed, struct cube *cubes, size_t count, size_t *failed);
+enum cubie_error pack_cubes_wide(const struct cube *cubes, struct wide_packed_cube *packed, size_t count, size_t *failed);
+enum cubie_error unpack_cubes_wide(const struct wide_packed_cube *packed, struct cube *cubes, size_t count, size_t *failed);
+#endif //PACK_H
@@ -0,0 +1,66 @@
+#include "random.h"
+#include <time.h>
+#include "util.h"
+
+uint64_t splitmix64(uint64_t *state) {
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+void seed_random(struct random *random, uint64_t seed) {
+	// splitmix64 never gives four zeros in a row, which is the one state xoshiro can not leave
+	for (int i = 0; i < 4; ++i) random->state[i] = splitmix64(&seed);
+}
+
+uint64_t get_random_seed() {
+	// the wall clock differs between runs and the monotonic one between calls in the same second
+	uint64_t state = (uint64_t) time(NULL) ^ get_time_ns() << 20;
+	return splitmix64(&state) >> 1;
+}
+
+static uint64_t rotate_left(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+uint64_t get_random(struct random *random) {
+	uint64_t *s = random->state;
+	uint64_t result = rotate_left(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotate_left(s[3], 45);
+	return result;
+}
+
+uint32_t get_random_below(struct random *random, uint32_t bound) {
+	// lemire's method, scales a 32 bit number up to the bound and retries the few that would make some results more likely
+	uint64_t product = (get_random(random) >> 32) * bound;
+	uint32_t low = product;
+	if (low < bound) {
+		uint32_t threshold = -bound % bound;
+		while (low < threshold) {
+			product = (get_random(random) >> 32) * bound;
+			low = product;
+		}
+	}
+	return product >> 32;
+}
+
+void jump_random(struct random *random) {
+	static const uint64_t jump[4] = {0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+	uint64_t s[4] = {0, 0, 0, 0};
+	for (int i = 0; i < 4; ++i) {
+		for (int bit = 0; bit < 64; ++bit) {
+			if (jump[i] & 1ull << bit) {
+				for (int j = 0; j < 4; ++j) s[j] ^= random->state[j];
+			}
+			get_random(random);
+		}
+	}
+	for (int i = 0; i < 4; ++i) random->state[i] = s[i];
+}
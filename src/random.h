@@ -0,0 +1,19 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+#include <stdint.h>
+
+// xoshiro256** seeded with splitmix64, fast and the same on every machine for the same seed, not for anything secret
+
+struct random {
+	uint64_t state[4];
+};
+
+uint64_t splitmix64(uint64_t *state);
+void seed_random(struct random *random, uint64_t seed);
+// a seed that is different every time, below 2^63 so it also fits in a long
+uint64_t get_random_seed();
+uint64_t get_random(struct random *random);
+uint32_t get_random_below(struct random *random, uint32_t bound);
+// skips 2^128 numbers, so each thread can take its own stream of the same seed without them overlapping
+void jump_random(struct random *random);
+#endif //RANDOM_H
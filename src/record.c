@@ -0,0 +1,211 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include "record.h"
+#include "err.h"
+#include "moves.h"
+#include "util.h"
+
+// longest varint, enough for any 64 bit number
+#define VARINT_MAX_SIZE 10
+// longest the replay thread sleeps at once, so it notices stop_replay_thread soon
+#define REPLAY_MAX_SLEEP_NS 10000000ull
+// how long the replay thread waits for room in the inbox
+#define REPLAY_FULL_SLEEP_NS 1000000ull
+
+static const char *const source_names[SOURCE_COUNT] = {
+        [SOURCE_KEYBOARD] = "keyboard",
+        [SOURCE_SHUFFLE] = "shuffle",
+        [SOURCE_SOLUTION] = "solution",
+        [SOURCE_SCRIPT] = "script",
+};
+
+static FILE *record_file = NULL;
+static const char *record_path;
+static uint64_t last_record_us;
+
+static struct {
+	pthread_t thread;
+	bool started;
+	atomic_bool stop;
+	struct replay *replay;
+	double speed;
+} player;
+
+const char *get_move_source_name(enum move_source source) {
+	return source < SOURCE_COUNT ? source_names[source] : "unknown";
+}
+
+static void fail_recording() {
+	// a full disk should not end the session, only the log
+	warn("%s: recording stopped", record_path);
+	fclose(record_file);
+	record_file = NULL;
+}
+
+bool start_recording(const char *path, const struct cube *cube) {
+	record_file = fopen(path, "wb");
+	if (!record_file) {
+		warn("%s", path);
+		return false;
+	}
+	record_path = path;
+	last_record_us = get_time_ns() / 1000;
+	if (fwrite(RECORD_MAGIC, 1, RECORD_MAGIC_SIZE, record_file) != RECORD_MAGIC_SIZE || fwrite(cube->stickers, 1, 9 * 6, record_file) != 9 * 6) {
+		fail_recording();
+		return false;
+	}
+	return true;
+}
+
+void record_move(struct move move, enum move_source source) {
+	if (!record_file) return;
+	int index = get_move_index(move);
+	if (index < 0) return;
+
+	// times are stored as differences, which are small and take one or two bytes most of the time
+	uint64_t now = get_time_ns() / 1000;
+	uint64_t delta = now - last_record_us;
+	last_record_us = now;
+
+	uint8_t bytes[1 + VARINT_MAX_SIZE];
+	size_t size = 0;
+	bytes[size++] = index | source << 6;
+	do {
+		bytes[size++] = (delta & 0x7f) | (delta > 0x7f ? 0x80 : 0);
+		delta >>= 7;
+	} while (delta);
+	if (fwrite(bytes, 1, size, record_file) != size) fail_recording();
+}
+
+void flush_recording() {
+	// called once a frame, so a crash loses at most the moves of the last frame
+	if (record_file && fflush(record_file) != 0) fail_recording();
+}
+
+bool stop_recording(const struct cube *cube) {
+	if (!record_file) return true;
+	bool ok = putc(RECORD_END, record_file) != EOF && fwrite(cube->stickers, 1, 9 * 6, record_file) == 9 * 6;
+	ok = fclose(record_file) == 0 && ok;
+	record_file = NULL;
+	if (!ok) warn("%s", record_path);
+	return ok;
+}
+
+static bool read_stickers(struct replay *replay, struct cube *cube) {
+	if (fread(cube->stickers, 1, 9 * 6, replay->file) != 9 * 6) return false;
+	replay->offset += 9 * 6;
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		if (cube->stickers[i] >= 6) return false;
+	}
+	return true;
+}
+
+bool open_replay(const char *path, struct replay *replay) {
+	*replay = (struct replay){.path = path};
+	replay->file = fopen(path, "rb");
+	if (!replay->file) {
+		warn("%s", path);
+		return false;
+	}
+
+	char magic[RECORD_MAGIC_SIZE];
+	if (fread(magic, 1, RECORD_MAGIC_SIZE, replay->file) != RECORD_MAGIC_SIZE || memcmp(magic, RECORD_MAGIC, RECORD_MAGIC_SIZE) != 0) {
+		warnx("%s: not a recorded session", path);
+		close_replay(replay);
+		return false;
+	}
+	replay->offset = RECORD_MAGIC_SIZE;
+	if (!read_stickers(replay, &replay->start)) {
+		warnx("%s: invalid starting cube", path);
+		close_replay(replay);
+		return false;
+	}
+	return true;
+}
+
+enum replay_result read_replay_move(struct replay *replay, struct recorded_move *move) {
+	int c = getc(replay->file);
+	if (c == EOF) return REPLAY_END;
+	++replay->offset;
+
+	if (c == RECORD_END) {
+		if (!read_stickers(replay, &replay->end)) {
+			warnx("%s: invalid final cube at byte %zu", replay->path, replay->offset);
+			return REPLAY_ERROR;
+		}
+		replay->finished = true;
+		return REPLAY_END;
+	}
+
+	int index = c & 0x3f;
+	if (index >= MOVE_COUNT) {
+		warnx("%s: invalid move at byte %zu", replay->path, replay->offset);
+		return REPLAY_ERROR;
+	}
+	move->move = (struct move){.face = move_faces[index / 3], .dir = index % 3};
+	move->source = c >> 6;
+
+	uint64_t delta = 0;
+	for (int shift = 0;; shift += 7) {
+		// a move cut off by a crash is the end of the log
+		c = getc(replay->file);
+		if (c == EOF) return REPLAY_END;
+		++replay->offset;
+		if (shift >= 7 * VARINT_MAX_SIZE) {
+			warnx("%s: invalid time at byte %zu", replay->path, replay->offset);
+			return REPLAY_ERROR;
+		}
+		delta |= (uint64_t) (c & 0x7f) << shift;
+		if (!(c & 0x80)) break;
+	}
+	replay->time_us += delta;
+	move->time_us = replay->time_us;
+	return REPLAY_MOVE;
+}
+
+void close_replay(struct replay *replay) {
+	if (replay->file) fclose(replay->file);
+	replay->file = NULL;
+}
+
+static void sleep_ns(uint64_t time) {
+	struct timespec ts = {.tv_sec = time / 1000000000ull, .tv_nsec = time % 1000000000ull};
+	nanosleep(&ts, NULL);
+}
+
+static void *replay_thread(void *data) {
+	uint64_t start = get_time_ns();
+	struct recorded_move move;
+	while (!atomic_load(&player.stop) && read_replay_move(player.replay, &move) == REPLAY_MOVE) {
+		if (player.speed > 0) {
+			uint64_t time = start + (uint64_t) (move.time_us * 1000 / player.speed);
+			for (uint64_t now; !atomic_load(&player.stop) && (now = get_time_ns()) < time;) {
+				sleep_ns(time - now < REPLAY_MAX_SLEEP_NS ? time - now : REPLAY_MAX_SLEEP_NS);
+			}
+		}
+		// the inbox fills up when the moves come faster than the window takes them, so wait instead of dropping any
+		while (!atomic_load(&player.stop) && post_move(move.move) == SEND_FULL) sleep_ns(REPLAY_FULL_SLEEP_NS);
+	}
+	return NULL;
+}
+
+bool start_replay_thread(struct replay *replay, double speed) {
+	player.replay = replay;
+	player.speed = speed;
+	atomic_init(&player.stop, false);
+	if (pthread_create(&player.thread, NULL, replay_thread, NULL) != 0) {
+		warnx("Failed to start replay thread");
+		return false;
+	}
+	player.started = true;
+	return true;
+}
+
+void stop_replay_thread() {
+	if (!player.started) return;
+	atomic_store(&player.stop, true);
+	pthread_join(player.thread, NULL);
+	player.started = false;
+}
@@ -0,0 +1,62 @@
+#ifndef RECORD_H
+#define RECORD_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "rubik.h"
+
+// append only log of every move applied to the cube
+// it starts with RECORD_MAGIC and the 54 stickers of the cube at the start
+// each move is a byte with the move index in the low 6 bits and its source in the high 2 bits,
+// then the microseconds since the move before it as a varint, 7 bits to a byte with the high bit set on all but the last
+// RECORD_END and the 54 stickers of the final cube close the log, without them the session was cut short
+
+#define RECORD_MAGIC "RUBIKLOG\1"
+#define RECORD_MAGIC_SIZE 9
+#define RECORD_END 0xff
+
+// where a queued move came from
+enum move_source {
+	SOURCE_KEYBOARD,
+	SOURCE_SHUFFLE,
+	SOURCE_SOLUTION,
+	SOURCE_SCRIPT, // posted from another thread, like a replay
+	SOURCE_COUNT,
+};
+
+struct recorded_move {
+	struct move move;
+	enum move_source source;
+	uint64_t time_us; // since the start of the log
+};
+
+struct replay {
+	FILE *file;
+	const char *path;
+	struct cube start, end;
+	bool finished; // the log was closed properly and end is the final cube
+	uint64_t time_us;
+	size_t offset; // bytes read so far, for errors
+};
+
+enum replay_result {
+	REPLAY_MOVE,
+	REPLAY_END,   // no more moves, finished tells whether the log was closed properly
+	REPLAY_ERROR, // damaged log, already reported
+};
+
+const char *get_move_source_name(enum move_source source);
+
+bool start_recording(const char *path, const struct cube *cube);
+void record_move(struct move move, enum move_source source);
+void flush_recording();
+bool stop_recording(const struct cube *cube);
+
+bool open_replay(const char *path, struct replay *replay);
+enum replay_result read_replay_move(struct replay *replay, struct recorded_move *move);
+void close_replay(struct replay *replay);
+
+// posts the moves of the log from another thread at their recorded times divided by speed, or all at once with a speed of 0
+bool start_replay_thread(struct replay *replay, double speed);
+void stop_replay_thread();
+#endif //RECORD_H
@@ -144,12 +144,12 @@ void unload() {
 extern const struct move_map moves_map[][4];
 extern const intpos faces_map[];
 
-static GLuint animation[4] = {0, 0, 0, 0}; // current animation
+static GLuint animations[ANIMATION_SLOTS][4]; // current animations, one uvec4 each
 
 static bool update_animation() {
 	glUseProgram(shader_program);
-	GLint animation_uniform = glGetUniformLocation(shader_program, "animation");
-	if (animation_uniform >= 0) glUniform4uiv(animation_uniform, 1, animation);
+	GLint animation_uniform = glGetUniformLocation(shader_program, "animations");
+	if (animation_uniform >= 0) glUniform4uiv(animation_uniform, ANIMATION_SLOTS, animations[0]);
 
 	GLenum error = glGetError();
 	if (error != GL_NO_ERROR) {
@@ -159,23 +159,16 @@ static bool update_animation() {
 	return true;
 }
 
-static GLuint *get_animation(struct sticker_rotations ani) {
-	// compact all the data of the struct into a uvec4
-	return (GLuint[4]){
-	        ani.axis - AXIS_X + (ani.dir * 3),
-	        ani.stickers,
-	        ani.stickers >> 32,
-	        ani.start_time};
+static void get_animation(struct sticker_rotations ani, GLuint *animation) {
+	// compact all the data of the struct into a uvec4, the turn time fits above the axis and direction
+	animation[0] = ani.axis - AXIS_X + (ani.dir * 3) + (ani.turn_time << 4);
+	animation[1] = ani.stickers;
+	animation[2] = ani.stickers >> 32;
+	animation[3] = ani.start_time;
 }
 
-bool send_animation(struct sticker_rotations ani) {
-	GLuint *anim = get_animation(ani);
-
-	// copy the uvec4
-	for (int i = 0; i < 4; i++) {
-		animation[i] = anim[i];
-	}
-
+bool send_animation(int slot, struct sticker_rotations ani) {
+	get_animation(ani, animations[slot]);
 	return update_animation();
 }
 
@@ -363,8 +356,6 @@ bool initialize_render() {
 
 	if (!update_animation()) goto error;
 
-	update_render_turn_time();
-
 	GLenum error = glGetError();
 	if (error != GL_NO_ERROR) {
 		warnx("OpenGL error: %i", error);
@@ -439,9 +430,3 @@ void render() {
 	glDrawArrays(GL_QUADS, 0, vertices_total_count);
 	glBindVertexArray(0);
 }
-
-void update_render_turn_time() {
-	if (!shader_program) return;
-	GLint turn_time_uniform = glGetUniformLocation(shader_program, "turnTime");
-	if (turn_time_uniform >= 0) glUniform1ui(turn_time_uniform, current_turn_time);
-}
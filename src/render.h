@@ -5,8 +5,9 @@ void reset_camera();
 void rotate_camera(float x, float y);
 void unload();
 bool initialize_render();
-bool send_animation(struct sticker_rotations animation);
+// rotations the shader can animate at once, must match the shader
+#define ANIMATION_SLOTS 4
+bool send_animation(int slot, struct sticker_rotations animation);
 bool update_cube(struct cube *cube);
 void render();
-void update_render_turn_time();
 #endif
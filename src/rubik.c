@@ -3,13 +3,16 @@
 #include "moves.h"
 
 char get_char_move_face(enum move_face face) {
-	return "URFDLBurfdlbMESxyz"[face];
+	// every face is already stored as its character
+	return face;
 }
 
 char get_char_move_direction(enum move_direction dir) {
 	return "\0'2"[dir];
 }
 
+const enum move_face move_faces[MOVE_FACE_COUNT] = {U, R, F, D, L, B, u, r, f, d, l, b, M, E, S, x, y, z};
+
 struct base_rotation {
 	enum rotation_face face;
 	enum move_direction dir;
@@ -49,7 +52,9 @@ const intpos faces_map[] = {
         [FACE_S] = 8,
 };
 
-void make_move(struct cube *cube, struct move move, struct sticker_rotations *animation) {
+// reference implementation of a move, rotates each layer one quarter turn at a time
+// only used to build the move tables, use make_move instead
+static void make_move_layers(struct cube *cube, struct move move, struct sticker_rotations *animation) {
 	struct base_rotation rotations[3] = {
 	        {.face = NONE},
 	        {.face = NONE},
@@ -213,7 +218,7 @@ void make_move(struct cube *cube, struct move move, struct sticker_rotations *an
 				struct face old_face = old_cube.faces[rotation_face_i];
 
 				// bitmask for all 9 stickers
-				animation->stickers |= get_face_bitmask(rotation_face_i);
+				if (animation) animation->stickers |= get_face_bitmask(rotation_face_i);
 
 				// rotate top stickers
 				rotate_face->top_right = old_face.top_left;
@@ -231,6 +236,125 @@ void make_move(struct cube *cube, struct move move, struct sticker_rotations *an
 	return;
 }
 
+// precomputed sticker permutation and animation for every move and direction
+struct move_table {
+	struct permutation permutation;
+	struct sticker_rotations animation;
+};
+
+static struct move_table move_tables[MOVE_COUNT];
+static bool move_tables_initialized = false;
+
+void init_move_tables() {
+	if (move_tables_initialized) return;
+
+	for (intpos face_i = 0; face_i < MOVE_FACE_COUNT; ++face_i) {
+		for (intpos dir = cw; dir <= dbl; ++dir) {
+			struct move move = {.face = move_faces[face_i], .dir = dir};
+			struct move_table *table = &move_tables[face_i * 3 + dir];
+
+			// apply the move to a cube where every sticker is its own index
+			// so the result tells us where each sticker came from
+			struct cube cube;
+			for (intpos i = 0; i < 9 * 6; ++i) cube.stickers[i] = i;
+			make_move_layers(&cube, move, &table->animation);
+			table->animation.start_time = 0;
+			table->animation.turn_time = 0;
+
+			for (intpos i = 0; i < 9 * 6; ++i) table->permutation.stickers[i] = cube.stickers[i];
+		}
+	}
+
+	move_tables_initialized = true;
+}
+
+// index of each face in move_faces plus one, zero for invalid faces
+static const intpos move_face_indices[] = {
+        [U] = 1,
+        [R] = 2,
+        [F] = 3,
+        [D] = 4,
+        [L] = 5,
+        [B] = 6,
+        [u] = 7,
+        [r] = 8,
+        [f] = 9,
+        [d] = 10,
+        [l] = 11,
+        [b] = 12,
+        [M] = 13,
+        [E] = 14,
+        [S] = 15,
+        [x] = 16,
+        [y] = 17,
+        [z] = 18,
+};
+
+int get_move_index(struct move move) {
+	if ((unsigned) move.face >= sizeof(move_face_indices) / sizeof(move_face_indices[0])) return -1;
+	if ((unsigned) move.dir > dbl) return -1;
+	intpos face_index = move_face_indices[move.face];
+	if (!face_index) return -1;
+	return (face_index - 1) * 3 + move.dir;
+}
+
+const struct permutation *get_move_permutation(struct move move) {
+	int index = get_move_index(move);
+	if (index < 0) return NULL;
+	init_move_tables();
+	return &move_tables[index].permutation;
+}
+
+void apply_permutation(struct cube *cube, const struct permutation *permutation) {
+	struct cube old_cube = *cube;
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		cube->stickers[i] = old_cube.stickers[permutation->stickers[i]];
+	}
+}
+
+void reset_permutation(struct permutation *permutation) {
+	for (intpos i = 0; i < 9 * 6; ++i) permutation->stickers[i] = i;
+}
+
+void compose_permutation(struct permutation *result, const struct permutation *first, const struct permutation *second) {
+	// applying first then second moves the sticker at first[second[i]] to i
+	struct permutation composed;
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		composed.stickers[i] = first->stickers[second->stickers[i]];
+	}
+	*result = composed;
+}
+
+void invert_permutation(struct permutation *result, const struct permutation *permutation) {
+	struct permutation inverted;
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		inverted.stickers[permutation->stickers[i]] = i;
+	}
+	*result = inverted;
+}
+
+const struct sticker_rotations *get_move_animation(struct move move) {
+	int index = get_move_index(move);
+	if (index < 0) return NULL;
+	init_move_tables();
+	return &move_tables[index].animation;
+}
+
+void make_move(struct cube *cube, struct move move, struct sticker_rotations *animation) {
+	int index = get_move_index(move);
+	if (index < 0) return;
+	init_move_tables();
+
+	const struct move_table *table = &move_tables[index];
+	apply_permutation(cube, &table->permutation);
+
+	if (animation) {
+		animation->axis = table->animation.axis;
+		animation->dir = table->animation.dir;
+		animation->stickers = table->animation.stickers;
+	}
+}
+
 void reset_cube(struct cube *cube) {
 	for (intpos face = 0; face < 6; ++face) {
 		for (intpos sticker = 0; sticker < 9; ++sticker) {
@@ -89,6 +89,7 @@ struct sticker_rotations {
 	enum move_direction dir;
 	uint64_t stickers;   // bitmask of what stickers to rotate
 	uint32_t start_time; // SDL_GetTicks
+	uint32_t turn_time;  // how long the rotation takes
 };
 
 // stores which pieces are moved during a rotation
@@ -109,8 +110,28 @@ struct move_map {
 	enum stickers stickers[3];
 };
 
+// every move face, in the order used by move indices
+#define MOVE_FACE_COUNT 18
+// every move face and direction combination
+#define MOVE_COUNT (MOVE_FACE_COUNT * 3)
+extern const enum move_face move_faces[MOVE_FACE_COUNT];
+
+// permutation of all the stickers on a cube
+// stickers[i] is the index of the sticker that moves into index i
+struct permutation {
+	intpos stickers[9 * 6];
+};
+
 char get_char_move_face(enum move_face);
 char get_char_move_direction(enum move_direction);
+void init_move_tables();
+int get_move_index(struct move move);
+const struct permutation *get_move_permutation(struct move move);
+void apply_permutation(struct cube *cube, const struct permutation *permutation);
+void reset_permutation(struct permutation *permutation);
+void compose_permutation(struct permutation *result, const struct permutation *first, const struct permutation *second);
+void invert_permutation(struct permutation *result, const struct permutation *permutation);
+const struct sticker_rotations *get_move_animation(struct move move);
 void make_move(struct cube *cube, struct move move, struct sticker_rotations *animation);
 void reset_cube(struct cube *);
 intpos get_sticker_index(intpos face_no, intpos sticker_i);
@@ -0,0 +1,36 @@
+#include "scramble.h"
+#include "coord.h"
+#include "pack.h"
+
+void get_random_cubie(struct random *random, struct cubie_cube *cube) {
+	// each part of the state on its own, only the parity of the two permutations has to match
+	uint8_t permutation[12];
+	set_permutation_rank(permutation, 8, get_random_below(random, CORNERS_COUNT));
+	for (intpos i = 0; i < 8; ++i) cube->corners[i] = MAKE_CORNER(permutation[i], 0);
+	set_permutation_rank(permutation, 12, get_random_below(random, EDGES_COUNT));
+	for (intpos i = 0; i < 12; ++i) cube->edges[i] = MAKE_EDGE(permutation[i], 0);
+
+	// swapping two edges pairs every odd permutation with an even one, so the result stays uniform
+	if (get_corner_parity(cube) != get_edge_parity(cube)) {
+		uint8_t edge = cube->edges[10];
+		cube->edges[10] = cube->edges[11];
+		cube->edges[11] = edge;
+	}
+
+	set_twist(cube, get_random_below(random, TWIST_COUNT));
+	set_flip(cube, get_random_below(random, FLIP_COUNT));
+}
+
+enum cubie_error get_scramble(const struct cubie_cube *cube, const struct solve_options *options, struct solution *scramble) {
+	enum cubie_error error = solve_cubie(cube, options, scramble);
+	if (error != CUBIE_OK) return error;
+
+	// reverse the order and turn each move the other way
+	for (size_t i = 0, j = scramble->length; i < j--; ++i) {
+		struct move move = scramble->moves[i];
+		scramble->moves[i] = scramble->moves[j];
+		scramble->moves[j] = move;
+	}
+	for (size_t i = 0; i < scramble->length; ++i) scramble->moves[i].dir = FLIP_DIR(scramble->moves[i].dir);
+	return CUBIE_OK;
+}
@@ -0,0 +1,12 @@
+#ifndef SCRAMBLE_H
+#define SCRAMBLE_H
+#include "cubie.h"
+#include "random.h"
+#include "solver.h"
+
+// random state scrambles, every one of the 43252003274489856000 legal cubes is as likely as any other
+
+void get_random_cubie(struct random *random, struct cubie_cube *cube);
+// moves that take a solved cube to cube, which is a solution of it played backwards
+enum cubie_error get_scramble(const struct cubie_cube *cube, const struct solve_options *options, struct solution *scramble);
+#endif //SCRAMBLE_H
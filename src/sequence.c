@@ -0,0 +1,81 @@
+#include "sequence.h"
+
+void reset_compiled_moves(struct compiled_moves *compiled) {
+	reset_permutation(&compiled->permutation);
+	compiled->stickers = 0;
+}
+
+void compile_moves(struct compiled_moves *compiled, const struct move *moves, size_t count) {
+	reset_compiled_moves(compiled);
+	for (size_t i = 0; i < count; ++i) {
+		const struct permutation *permutation = get_move_permutation(moves[i]);
+		if (!permutation) continue;
+		compose_permutation(&compiled->permutation, &compiled->permutation, permutation);
+		compiled->stickers |= get_move_animation(moves[i])->stickers;
+	}
+}
+
+void compose_compiled_moves(struct compiled_moves *result, const struct compiled_moves *first, const struct compiled_moves *second) {
+	uint64_t stickers = first->stickers | second->stickers;
+	compose_permutation(&result->permutation, &first->permutation, &second->permutation);
+	result->stickers = stickers;
+}
+
+void invert_compiled_moves(struct compiled_moves *result, const struct compiled_moves *compiled) {
+	// the inverse touches the same stickers
+	uint64_t stickers = compiled->stickers;
+	invert_permutation(&result->permutation, &compiled->permutation);
+	result->stickers = stickers;
+}
+
+void power_compiled_moves(struct compiled_moves *result, const struct compiled_moves *compiled, int64_t exponent) {
+	struct compiled_moves base = *compiled;
+	if (exponent < 0) invert_compiled_moves(&base, &base);
+	// negated as unsigned, so INT64_MIN has a magnitude too
+	uint64_t n = exponent < 0 ? -(uint64_t) exponent : (uint64_t) exponent;
+
+	// square and multiply, powers of one permutation commute so the order does not matter
+	struct compiled_moves power;
+	reset_compiled_moves(&power);
+	for (; n; n >>= 1) {
+		if (n & 1) compose_compiled_moves(&power, &power, &base);
+		compose_compiled_moves(&base, &base, &base);
+	}
+	*result = power;
+}
+
+bool is_compiled_moves_identity(const struct compiled_moves *compiled) {
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		if (compiled->permutation.stickers[i] != i) return false;
+	}
+	return true;
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+	while (b) {
+		uint64_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+uint64_t get_compiled_moves_order(const struct compiled_moves *compiled) {
+	// the order is the least common multiple of the cycle lengths
+	uint64_t order = 1;
+	uint64_t visited = 0;
+	for (intpos start = 0; start < 9 * 6; ++start) {
+		if (visited & (1ull << start)) continue;
+		uint64_t length = 0;
+		for (intpos i = start; !(visited & (1ull << i)); i = compiled->permutation.stickers[i]) {
+			visited |= 1ull << i;
+			++length;
+		}
+		order = order / gcd(order, length) * length;
+	}
+	return order;
+}
+
+void apply_compiled_moves(struct cube *cube, const struct compiled_moves *compiled) {
+	apply_permutation(cube, &compiled->permutation);
+}
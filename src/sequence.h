@@ -0,0 +1,20 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+#include <stddef.h>
+#include "rubik.h"
+
+// a whole move sequence folded into one sticker permutation
+struct compiled_moves {
+	struct permutation permutation;
+	uint64_t stickers; // bitmask of every sticker moved by any move in the sequence
+};
+
+void reset_compiled_moves(struct compiled_moves *compiled);
+void compile_moves(struct compiled_moves *compiled, const struct move *moves, size_t count);
+void compose_compiled_moves(struct compiled_moves *result, const struct compiled_moves *first, const struct compiled_moves *second);
+void invert_compiled_moves(struct compiled_moves *result, const struct compiled_moves *compiled);
+void power_compiled_moves(struct compiled_moves *result, const struct compiled_moves *compiled, int64_t exponent);
+bool is_compiled_moves_identity(const struct compiled_moves *compiled);
+uint64_t get_compiled_moves_order(const struct compiled_moves *compiled);
+void apply_compiled_moves(struct cube *cube, const struct compiled_moves *compiled);
+#endif //SEQUENCE_H
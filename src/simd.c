@@ -0,0 +1,214 @@
+#include "simd.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+// number of permutation pointers passed to a kernel at once
+#define KERNEL_BATCH 64
+
+typedef void (*simd_kernel)(uint8_t *state, const struct simd_permutation *const *permutations, size_t count);
+
+static struct simd_permutation simd_moves[MOVE_COUNT];
+static bool simd_initialized = false;
+static enum simd_level current_level = SIMD_SCALAR;
+
+static const char *const simd_level_names[SIMD_LEVEL_COUNT] = {
+        [SIMD_SCALAR] = "scalar",
+        [SIMD_SSSE3] = "ssse3",
+        [SIMD_AVX2] = "avx2",
+        [SIMD_AVX512VBMI] = "avx512vbmi",
+};
+
+// state is always a 64 byte aligned buffer holding the 54 stickers followed by zeroes
+
+static void apply_scalar(uint8_t *state, const struct simd_permutation *const *permutations, size_t count) {
+	uint8_t old_state[9 * 6];
+	for (size_t i = 0; i < count; ++i) {
+		memcpy(old_state, state, sizeof(old_state));
+		for (intpos j = 0; j < 9 * 6; ++j) {
+			state[j] = old_state[permutations[i]->indices[j]];
+		}
+	}
+}
+
+#ifdef SIMD_X86
+__attribute__((target("ssse3"))) static void apply_ssse3(uint8_t *state, const struct simd_permutation *const *permutations, size_t count) {
+	__m128i chunks[4];
+	for (intpos k = 0; k < 4; ++k) chunks[k] = _mm_load_si128((const __m128i *) (state + k * 16));
+
+	for (size_t i = 0; i < count; ++i) {
+		const struct simd_permutation *permutation = permutations[i];
+		__m128i out[4];
+		for (intpos j = 0; j < 4; ++j) {
+			// gather the bytes for this output chunk from each of the 4 source chunks
+			__m128i o = _mm_shuffle_epi8(chunks[0], _mm_load_si128((const __m128i *) permutation->masks[0][j]));
+			o = _mm_or_si128(o, _mm_shuffle_epi8(chunks[1], _mm_load_si128((const __m128i *) permutation->masks[1][j])));
+			o = _mm_or_si128(o, _mm_shuffle_epi8(chunks[2], _mm_load_si128((const __m128i *) permutation->masks[2][j])));
+			o = _mm_or_si128(o, _mm_shuffle_epi8(chunks[3], _mm_load_si128((const __m128i *) permutation->masks[3][j])));
+			out[j] = o;
+		}
+		for (intpos k = 0; k < 4; ++k) chunks[k] = out[k];
+	}
+
+	for (intpos k = 0; k < 4; ++k) _mm_store_si128((__m128i *) (state + k * 16), chunks[k]);
+}
+
+__attribute__((target("avx2"))) static void apply_avx2(uint8_t *state, const struct simd_permutation *const *permutations, size_t count) {
+	__m256i low = _mm256_load_si256((const __m256i *) state);
+	__m256i high = _mm256_load_si256((const __m256i *) (state + 32));
+
+	for (size_t i = 0; i < count; ++i) {
+		const struct simd_permutation *permutation = permutations[i];
+
+		// vpshufb only shuffles within 128 bit lanes, so copy each source chunk into both lanes
+		__m256i sources[4] = {
+		        _mm256_permute2x128_si256(low, low, 0x00),
+		        _mm256_permute2x128_si256(low, low, 0x11),
+		        _mm256_permute2x128_si256(high, high, 0x00),
+		        _mm256_permute2x128_si256(high, high, 0x11),
+		};
+
+		// masks[k][j] and masks[k][j + 1] are next to each other so they form one 32 byte mask
+		__m256i out[2];
+		for (intpos j = 0; j < 2; ++j) {
+			__m256i o = _mm256_shuffle_epi8(sources[0], _mm256_load_si256((const __m256i *) permutation->masks[0][j * 2]));
+			o = _mm256_or_si256(o, _mm256_shuffle_epi8(sources[1], _mm256_load_si256((const __m256i *) permutation->masks[1][j * 2])));
+			o = _mm256_or_si256(o, _mm256_shuffle_epi8(sources[2], _mm256_load_si256((const __m256i *) permutation->masks[2][j * 2])));
+			o = _mm256_or_si256(o, _mm256_shuffle_epi8(sources[3], _mm256_load_si256((const __m256i *) permutation->masks[3][j * 2])));
+			out[j] = o;
+		}
+		low = out[0];
+		high = out[1];
+	}
+
+	_mm256_store_si256((__m256i *) state, low);
+	_mm256_store_si256((__m256i *) (state + 32), high);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi"))) static void apply_avx512vbmi(uint8_t *state, const struct simd_permutation *const *permutations, size_t count) {
+	__m512i cube = _mm512_load_si512((const void *) state);
+	for (size_t i = 0; i < count; ++i) {
+		cube = _mm512_permutexvar_epi8(_mm512_load_si512((const void *) permutations[i]->indices), cube);
+	}
+	_mm512_store_si512((void *) state, cube);
+}
+#endif
+
+static const simd_kernel kernels[SIMD_LEVEL_COUNT] = {
+        [SIMD_SCALAR] = apply_scalar,
+#ifdef SIMD_X86
+        [SIMD_SSSE3] = apply_ssse3,
+        [SIMD_AVX2] = apply_avx2,
+        [SIMD_AVX512VBMI] = apply_avx512vbmi,
+#endif
+};
+
+bool is_simd_level_supported(enum simd_level level) {
+	if ((unsigned) level >= SIMD_LEVEL_COUNT || !kernels[level]) return false;
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	switch (level) {
+		case SIMD_SSSE3:
+			return __builtin_cpu_supports("ssse3");
+		case SIMD_AVX2:
+			return __builtin_cpu_supports("avx2");
+		case SIMD_AVX512VBMI:
+			return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi");
+		default:
+			break;
+	}
+#endif
+	return level == SIMD_SCALAR;
+}
+
+const char *get_simd_level_name(enum simd_level level) {
+	if ((unsigned) level >= SIMD_LEVEL_COUNT) return "unknown";
+	return simd_level_names[level];
+}
+
+void compile_simd_permutation(const struct permutation *permutation, struct simd_permutation *simd_permutation) {
+	memset(simd_permutation->masks, 0x80, sizeof(simd_permutation->masks));
+	for (intpos i = 0; i < 64; ++i) {
+		if (i >= 9 * 6) {
+			// padding stays where it is
+			simd_permutation->indices[i] = i;
+			continue;
+		}
+		intpos source = permutation->stickers[i];
+		simd_permutation->indices[i] = source;
+		simd_permutation->masks[source / 16][i / 16][i % 16] = source % 16;
+	}
+}
+
+void init_simd() {
+	if (simd_initialized) return;
+
+	for (intpos i = 0; i < MOVE_FACE_COUNT; ++i) {
+		for (intpos dir = cw; dir <= dbl; ++dir) {
+			struct move move = {.face = move_faces[i], .dir = dir};
+			compile_simd_permutation(get_move_permutation(move), &simd_moves[i * 3 + dir]);
+		}
+	}
+
+	// pick the best instruction set the cpu supports
+	current_level = SIMD_SCALAR;
+	for (enum simd_level level = SIMD_SCALAR; level < SIMD_LEVEL_COUNT; ++level) {
+		if (is_simd_level_supported(level)) current_level = level;
+	}
+
+	simd_initialized = true;
+}
+
+enum simd_level get_simd_level() {
+	init_simd();
+	return current_level;
+}
+
+bool set_simd_level(enum simd_level level) {
+	init_simd();
+	if (!is_simd_level_supported(level)) return false;
+	current_level = level;
+	return true;
+}
+
+const struct simd_permutation *get_simd_move_permutation(struct move move) {
+	int index = get_move_index(move);
+	if (index < 0) return NULL;
+	init_simd();
+	return &simd_moves[index];
+}
+
+void apply_permutation_simd(struct cube *cube, const struct simd_permutation *permutation) {
+	init_simd();
+	uint8_t state[64] __attribute__((aligned(64))) = {0};
+	memcpy(state, cube->stickers, sizeof(cube->stickers));
+	kernels[current_level](state, &permutation, 1);
+	memcpy(cube->stickers, state, sizeof(cube->stickers));
+}
+
+void make_moves_simd(struct cube *cube, const struct move *moves, size_t count) {
+	init_simd();
+	simd_kernel kernel = kernels[current_level];
+
+	// the cube stays in registers for a whole batch of moves
+	uint8_t state[64] __attribute__((aligned(64))) = {0};
+	memcpy(state, cube->stickers, sizeof(cube->stickers));
+
+	const struct simd_permutation *permutations[KERNEL_BATCH];
+	size_t permutations_count = 0;
+	for (size_t i = 0; i < count; ++i) {
+		int index = get_move_index(moves[i]);
+		if (index < 0) continue;
+		permutations[permutations_count++] = &simd_moves[index];
+		if (permutations_count == KERNEL_BATCH) {
+			kernel(state, permutations, permutations_count);
+			permutations_count = 0;
+		}
+	}
+	if (permutations_count) kernel(state, permutations, permutations_count);
+
+	memcpy(cube->stickers, state, sizeof(cube->stickers));
+}
@@ -0,0 +1,32 @@
+#ifndef SIMD_H
+#define SIMD_H
+#include <stddef.h>
+#include "rubik.h"
+
+// instruction sets that can be used to apply moves
+enum simd_level {
+	SIMD_SCALAR,
+	SIMD_SSSE3,      // pshufb on 16 byte chunks
+	SIMD_AVX2,       // vpshufb on 32 byte chunks
+	SIMD_AVX512VBMI, // vpermb on the whole cube at once
+	SIMD_LEVEL_COUNT,
+};
+
+// shuffle masks for one permutation, used by every instruction set
+struct simd_permutation {
+	// masks[source chunk][output chunk] picks bytes from a 16 byte chunk of the cube into an output chunk, 0x80 zeroes the byte
+	uint8_t masks[4][4][16] __attribute__((aligned(64)));
+	// vpermb indices for the whole padded 64 byte cube
+	uint8_t indices[64] __attribute__((aligned(64)));
+};
+
+void init_simd();
+enum simd_level get_simd_level();
+bool set_simd_level(enum simd_level level);
+bool is_simd_level_supported(enum simd_level level);
+const char *get_simd_level_name(enum simd_level level);
+void compile_simd_permutation(const struct permutation *permutation, struct simd_permutation *simd_permutation);
+const struct simd_permutation *get_simd_move_permutation(struct move move);
+void apply_permutation_simd(struct cube *cube, const struct simd_permutation *permutation);
+void make_moves_simd(struct cube *cube, const struct move *moves, size_t count);
+#endif //SIMD_H
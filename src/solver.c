@@ -0,0 +1,586 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "solver.h"
+#include "coord.h"
+#include "optimal.h"
+#include "err.h"
+#include "util.h"
+#include "table_file.h"
+
+// two-phase solver
+// phase 1 brings the cube into the subgroup <U, D, R2, L2, F2, B2> where every corner and edge is oriented
+// and the middle layer edges are in the middle layer, phase 2 solves the cube using only those moves
+
+#define PRUNE_UNKNOWN 0xff
+
+// phase 1 pruning tables, indexed by slice * TWIST_COUNT + twist and slice * FLIP_COUNT + flip
+static const uint8_t *twist_slice_prune = NULL;
+static const uint8_t *flip_slice_prune = NULL;
+// phase 2 pruning tables, indexed by corners * 24 + slice_sorted and ud_edges * 24 + slice_sorted
+static const uint8_t *corners_slice_prune = NULL;
+static const uint8_t *ud_edges_slice_prune = NULL;
+
+// all pruning tables are stored one after another in this file
+static struct table_file prune_file;
+#define PRUNE_FILE_NAME "two-phase.tbl"
+// change this whenever the pruning tables are built differently
+#define PRUNE_TABLES_VERSION 1
+
+#define TWIST_SLICE_SIZE ((uint32_t) SLICE_COUNT * TWIST_COUNT)
+#define FLIP_SLICE_SIZE ((uint32_t) SLICE_COUNT * FLIP_COUNT)
+#define CORNERS_SLICE_SIZE ((uint32_t) CORNERS_COUNT * 24)
+#define UD_EDGES_SLICE_SIZE ((uint32_t) UD_EDGES_COUNT * 24)
+
+// moves allowed in phase 2: U, D and half turns of the other faces
+static const int phase2_moves[] = {0, 1, 2, 5, 8, 9, 10, 11, 14, 17};
+#define PHASE2_MOVE_COUNT (sizeof(phase2_moves) / sizeof(phase2_moves[0]))
+// longer phase 2 searches cost more than trying the next phase 1 depth, which almost always ends closer to G1
+// phase 2 needs up to 18 moves in theory, so cubes that need more than this come from longer phase 1 solutions instead
+#define PHASE2_MAX_DEPTH 10
+
+// how often the search checks the clock
+#define TIME_CHECK_NODES 4096
+// longest move sequence a search task can start with
+#define SPLIT_MAX_DEPTH 3
+
+static bool is_phase2_move(int move) {
+	for (size_t i = 0; i < PHASE2_MOVE_COUNT; ++i) {
+		if (phase2_moves[i] == move) return true;
+	}
+	return false;
+}
+
+static uint32_t next_twist_slice(uint32_t index, int move) {
+	uint32_t slice = index / TWIST_COUNT, twist = index % TWIST_COUNT;
+	return slice_sorted_move[slice * 24][move] / 24 * TWIST_COUNT + twist_move[twist][move];
+}
+
+static uint32_t next_flip_slice(uint32_t index, int move) {
+	uint32_t slice = index / FLIP_COUNT, flip = index % FLIP_COUNT;
+	return slice_sorted_move[slice * 24][move] / 24 * FLIP_COUNT + flip_move[flip][move];
+}
+
+static uint32_t next_corners_slice(uint32_t index, int move) {
+	return corners_move[index / 24][move] * 24 + slice_sorted_move[index % 24][move];
+}
+
+static uint32_t next_ud_edges_slice(uint32_t index, int move) {
+	return ud_edges_move[index / 24][move] * 24 + slice_sorted_move[index % 24][move];
+}
+
+// breadth first search from the solved state, storing the distance of every index
+static void build_prune_table(uint8_t *table, uint32_t size, uint32_t (*next)(uint32_t index, int move), const int *moves, size_t move_count) {
+	memset(table, PRUNE_UNKNOWN, size);
+	table[0] = 0;
+
+	uint32_t filled = 1;
+	for (uint8_t depth = 0; filled < size; ++depth) {
+		uint32_t last_filled = filled;
+		for (uint32_t index = 0; index < size; ++index) {
+			if (table[index] != depth) continue;
+			for (size_t i = 0; i < move_count; ++i) {
+				uint32_t next_index = next(index, moves[i]);
+				if (table[next_index] != PRUNE_UNKNOWN) continue;
+				table[next_index] = depth + 1;
+				++filled;
+			}
+		}
+		if (filled == last_filled) break;
+	}
+}
+
+static bool build_prune_tables(void *data, size_t size, void *userdata) {
+	int all_moves[CUBIE_MOVE_COUNT];
+	for (int i = 0; i < CUBIE_MOVE_COUNT; ++i) all_moves[i] = i;
+
+	uint8_t *table = data;
+	build_prune_table(table, TWIST_SLICE_SIZE, next_twist_slice, all_moves, CUBIE_MOVE_COUNT);
+	table += TWIST_SLICE_SIZE;
+	build_prune_table(table, FLIP_SLICE_SIZE, next_flip_slice, all_moves, CUBIE_MOVE_COUNT);
+	table += FLIP_SLICE_SIZE;
+	build_prune_table(table, CORNERS_SLICE_SIZE, next_corners_slice, phase2_moves, PHASE2_MOVE_COUNT);
+	table += CORNERS_SLICE_SIZE;
+	build_prune_table(table, UD_EDGES_SLICE_SIZE, next_ud_edges_slice, phase2_moves, PHASE2_MOVE_COUNT);
+	return true;
+}
+
+void init_solver() {
+	if (twist_slice_prune) return;
+	init_coord_tables();
+
+	size_t size = TWIST_SLICE_SIZE + FLIP_SLICE_SIZE + CORNERS_SLICE_SIZE + UD_EDGES_SLICE_SIZE;
+	// the pruning tables are built from the move tables, so they share their key
+	uint64_t key = get_coord_tables_key() ^ PRUNE_TABLES_VERSION;
+	if (!load_table_file(PRUNE_FILE_NAME, key, size, build_prune_tables, NULL, &prune_file)) {
+		errx(1, "Failed to load pruning tables");
+	}
+
+	const uint8_t *table = prune_file.data;
+	twist_slice_prune = table;
+	flip_slice_prune = table + TWIST_SLICE_SIZE;
+	corners_slice_prune = table + TWIST_SLICE_SIZE + FLIP_SLICE_SIZE;
+	ud_edges_slice_prune = table + TWIST_SLICE_SIZE + FLIP_SLICE_SIZE + CORNERS_SLICE_SIZE;
+}
+
+struct solve_options get_default_solve_options() {
+	return (struct solve_options){
+	        .target_length = 22,
+	        .time_limit_ns = 1000000000ull,
+	        .threads = get_cpu_count(),
+	        .optimal = false,
+	        .pattern_edges = DEFAULT_PATTERN_EDGES,
+	        .transposition_mb = DEFAULT_TRANSPOSITION_MB,
+	        .replacement = REPLACE_AGE,
+	        .on_solution = NULL,
+	        .userdata = NULL,
+	        .cancel = NULL,
+	};
+}
+
+// state shared by every thread working on the same cube
+struct search_shared {
+	struct cubie_cube cube;
+	const struct solve_options *options;
+	atomic_int best_length; // only look for solutions shorter than this
+	atomic_bool stop;
+	int target_length;
+	uint64_t start_time, deadline;
+	atomic_uint_fast64_t nodes;
+	pthread_mutex_t solution_lock;
+	struct solution *solution;
+};
+
+// state of one thread
+struct search {
+	struct search_shared *shared;
+	int path[MAX_SOLUTION_LENGTH]; // move indices of phase 1 followed by phase 2
+	uint64_t nodes;
+};
+
+// a phase 1 subtree handed to a worker, starting after the first few moves
+struct search_task {
+	int path[SPLIT_MAX_DEPTH];
+	uint16_t twist, flip, slice_sorted;
+};
+
+// tasks owned by one worker, the owner takes from the bottom and other workers steal from the top
+struct task_deque {
+	pthread_mutex_t lock;
+	struct search_task *tasks;
+	size_t top, bottom;
+};
+
+struct worker_pool {
+	struct search_shared *shared;
+	struct task_deque *deques;
+	int thread_count;
+	int depth1, split_depth; // current phase 1 depth and length of the task paths
+	bool done;
+	pthread_mutex_t start_lock; // held until every thread is started and the barriers exist
+	pthread_barrier_t start_barrier, end_barrier;
+};
+
+static int get_best_length(const struct search *search) {
+	return atomic_load_explicit(&search->shared->best_length, memory_order_relaxed);
+}
+
+static bool should_stop(const struct search *search) {
+	return atomic_load_explicit(&search->shared->stop, memory_order_relaxed);
+}
+
+static void check_time(struct search *search) {
+	if (++search->nodes % TIME_CHECK_NODES) return;
+	// keep going until there is at least one solution
+	struct search_shared *shared = search->shared;
+	if (shared->deadline && get_best_length(search) <= MAX_SOLUTION_LENGTH && get_time_ns() >= shared->deadline) {
+		atomic_store(&shared->stop, true);
+	}
+	if (shared->options->cancel && atomic_load(shared->options->cancel)) atomic_store(&shared->stop, true);
+}
+
+static int get_phase2_distance(uint16_t corners, uint16_t ud_edges, uint16_t slice) {
+	int a = corners_slice_prune[corners * 24 + slice], b = ud_edges_slice_prune[ud_edges * 24 + slice];
+	return a > b ? a : b;
+}
+
+static bool search_phase2(struct search *search, uint16_t corners, uint16_t ud_edges, uint16_t slice, int depth, int togo) {
+	if (togo == 0) return corners == 0 && ud_edges == 0 && slice == 0;
+	check_time(search);
+	if (should_stop(search)) return false;
+
+	int previous = depth > 0 ? search->path[depth - 1] : -1;
+	for (size_t i = 0; i < PHASE2_MOVE_COUNT; ++i) {
+		int move = phase2_moves[i];
+		if (!is_canonical_move(move, previous)) continue;
+		uint16_t next_corners = corners_move[corners][move];
+		uint16_t next_ud_edges = ud_edges_move[ud_edges][move];
+		uint16_t next_slice = slice_sorted_move[slice][move];
+		if (get_phase2_distance(next_corners, next_ud_edges, next_slice) >= togo) continue;
+		search->path[depth] = move;
+		if (search_phase2(search, next_corners, next_ud_edges, next_slice, depth + 1, togo - 1)) return true;
+	}
+	return false;
+}
+
+static void save_solution(struct search *search, int length) {
+	struct search_shared *shared = search->shared;
+	pthread_mutex_lock(&shared->solution_lock);
+
+	// another thread may have found a shorter one in the meantime
+	if (length < atomic_load(&shared->best_length)) {
+		struct solution *solution = shared->solution;
+		for (int i = 0; i < length; ++i) {
+			solution->moves[i].face = move_faces[search->path[i] / 3];
+			solution->moves[i].dir = search->path[i] % 3;
+		}
+		solution->length = length;
+		solution->time_ns = get_time_ns() - shared->start_time;
+		// only counts the nodes other threads have finished with so far
+		solution->nodes = atomic_load(&shared->nodes) + search->nodes;
+		if (shared->options->on_solution) shared->options->on_solution(solution, shared->options->userdata);
+
+		atomic_store(&shared->best_length, length);
+		if (length <= shared->target_length) atomic_store(&shared->stop, true);
+	}
+
+	pthread_mutex_unlock(&shared->solution_lock);
+}
+
+static void start_phase2(struct search *search, int depth1) {
+	// the phase 2 coordinates are not tracked in phase 1, so get them from the cubie cube
+	struct cubie_cube cube = search->shared->cube;
+	for (int i = 0; i < depth1; ++i) cubie_make_move_index(&cube, search->path[i]);
+	uint16_t corners = get_corners(&cube), ud_edges = get_ud_edges(&cube), slice = get_slice_sorted(&cube);
+
+	int max_depth2 = get_best_length(search) - 1 - depth1;
+	if (max_depth2 > PHASE2_MAX_DEPTH) max_depth2 = PHASE2_MAX_DEPTH;
+	for (int depth2 = get_phase2_distance(corners, ud_edges, slice); depth2 <= max_depth2; ++depth2) {
+		if (search_phase2(search, corners, ud_edges, slice, depth1, depth2)) {
+			save_solution(search, depth1 + depth2);
+			return;
+		}
+		if (should_stop(search)) return;
+	}
+}
+
+static int get_phase1_distance(uint16_t twist, uint16_t flip, uint16_t slice) {
+	int a = twist_slice_prune[slice * TWIST_COUNT + twist], b = flip_slice_prune[slice * FLIP_COUNT + flip];
+	return a > b ? a : b;
+}
+
+static void search_phase1(struct search *search, uint16_t twist, uint16_t flip, uint16_t slice_sorted, int depth, int togo) {
+	if (should_stop(search)) return;
+	if (togo == 0) {
+		// a phase 1 solution ending in a phase 2 move was already found at a shorter depth
+		if (depth > 0 && is_phase2_move(search->path[depth - 1])) return;
+		start_phase2(search, depth);
+		return;
+	}
+	check_time(search);
+
+	int previous = depth > 0 ? search->path[depth - 1] : -1;
+	for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+		if (!is_canonical_move(move, previous)) continue;
+		uint16_t next_twist = twist_move[twist][move];
+		uint16_t next_flip = flip_move[flip][move];
+		uint16_t next_slice_sorted = slice_sorted_move[slice_sorted][move];
+		if (get_phase1_distance(next_twist, next_flip, next_slice_sorted / 24) >= togo) continue;
+		search->path[depth] = move;
+		search_phase1(search, next_twist, next_flip, next_slice_sorted, depth + 1, togo - 1);
+		if (should_stop(search)) return;
+		// phase 2 may have lowered the bound below this depth
+		if (depth + togo >= get_best_length(search)) return;
+	}
+}
+
+// collects every node at split_depth that can still reach phase 1 in time
+static void collect_tasks(struct search_task *tasks, size_t *count, struct search_task *current, int depth, int split_depth, int depth1) {
+	if (depth == split_depth) {
+		tasks[(*count)++] = *current;
+		return;
+	}
+
+	int previous = depth > 0 ? current->path[depth - 1] : -1;
+	uint16_t twist = current->twist, flip = current->flip, slice_sorted = current->slice_sorted;
+	for (int move = 0; move < CUBIE_MOVE_COUNT; ++move) {
+		if (!is_canonical_move(move, previous)) continue;
+		current->twist = twist_move[twist][move];
+		current->flip = flip_move[flip][move];
+		current->slice_sorted = slice_sorted_move[slice_sorted][move];
+		if (get_phase1_distance(current->twist, current->flip, current->slice_sorted / 24) >= depth1 - depth) continue;
+		current->path[depth] = move;
+		collect_tasks(tasks, count, current, depth + 1, split_depth, depth1);
+	}
+	current->twist = twist;
+	current->flip = flip;
+	current->slice_sorted = slice_sorted;
+}
+
+static bool take_task(struct worker_pool *pool, int worker, struct search_task *task) {
+	// own tasks first, newest first
+	struct task_deque *own = &pool->deques[worker];
+	pthread_mutex_lock(&own->lock);
+	bool found = own->bottom > own->top;
+	if (found) *task = own->tasks[--own->bottom];
+	pthread_mutex_unlock(&own->lock);
+	if (found) return true;
+
+	// then steal the oldest task of another worker, those have the biggest subtrees left
+	for (int i = 1; i < pool->thread_count; ++i) {
+		struct task_deque *victim = &pool->deques[(worker + i) % pool->thread_count];
+		pthread_mutex_lock(&victim->lock);
+		found = victim->bottom > victim->top;
+		if (found) *task = victim->tasks[victim->top++];
+		pthread_mutex_unlock(&victim->lock);
+		if (found) return true;
+	}
+	return false;
+}
+
+static void run_tasks(struct worker_pool *pool, int worker) {
+	struct search search = {.shared = pool->shared, .nodes = 0};
+	struct search_task task;
+	while (!should_stop(&search) && take_task(pool, worker, &task)) {
+		memcpy(search.path, task.path, sizeof(int) * pool->split_depth);
+		search_phase1(&search, task.twist, task.flip, task.slice_sorted, pool->split_depth, pool->depth1 - pool->split_depth);
+	}
+	atomic_fetch_add(&pool->shared->nodes, search.nodes);
+}
+
+struct worker {
+	struct worker_pool *pool;
+	int index;
+	pthread_t thread;
+};
+
+static void *worker_thread(void *data) {
+	struct worker *worker = data;
+	struct worker_pool *pool = worker->pool;
+	pthread_mutex_lock(&pool->start_lock);
+	pthread_mutex_unlock(&pool->start_lock);
+	for (;;) {
+		pthread_barrier_wait(&pool->start_barrier);
+		if (pool->done) break;
+		run_tasks(pool, worker->index);
+		pthread_barrier_wait(&pool->end_barrier);
+	}
+	return NULL;
+}
+
+static bool solve_parallel(struct search_shared *shared, int thread_count, uint16_t twist, uint16_t flip, uint16_t slice_sorted, int min_depth1) {
+	// split the tree after enough moves that every thread gets several subtrees
+	int split_depth = thread_count > 16 ? 3 : 2;
+	size_t max_tasks = CUBIE_MOVE_COUNT;
+	for (int i = 1; i < split_depth; ++i) max_tasks *= CUBIE_MOVE_COUNT - 3;
+
+	int pool_size = thread_count;
+	struct worker_pool pool = {.shared = shared, .thread_count = thread_count, .done = false};
+	struct search_task *tasks = malloc(max_tasks * sizeof(struct search_task));
+	pool.deques = calloc(thread_count, sizeof(struct task_deque));
+	struct worker *workers = calloc(thread_count, sizeof(struct worker));
+	if (!tasks || !pool.deques || !workers) {
+		warn("Failed to allocate solver threads");
+		free(tasks);
+		free(pool.deques);
+		free(workers);
+		return false;
+	}
+
+	for (int i = 0; i < thread_count; ++i) pthread_mutex_init(&pool.deques[i].lock, NULL);
+	pthread_mutex_init(&pool.start_lock, NULL);
+	pthread_mutex_lock(&pool.start_lock);
+
+	// this thread is worker 0, carry on with fewer threads if some fail to start
+	int started = 1;
+	for (; started < thread_count; ++started) {
+		workers[started].pool = &pool;
+		workers[started].index = started;
+		if (pthread_create(&workers[started].thread, NULL, worker_thread, &workers[started]) != 0) {
+			warnx("Failed to start solver thread %d", started);
+			break;
+		}
+	}
+	thread_count = pool.thread_count = started;
+	pthread_barrier_init(&pool.start_barrier, NULL, thread_count);
+	pthread_barrier_init(&pool.end_barrier, NULL, thread_count);
+	pthread_mutex_unlock(&pool.start_lock);
+
+	struct search search = {.shared = shared, .nodes = 0};
+	for (int depth1 = min_depth1; depth1 < atomic_load(&shared->best_length) && !atomic_load(&shared->stop); ++depth1) {
+		// shallow trees are not worth splitting
+		if (depth1 <= split_depth) {
+			search_phase1(&search, twist, flip, slice_sorted, 0, depth1);
+			continue;
+		}
+
+		size_t count = 0;
+		struct search_task root = {.twist = twist, .flip = flip, .slice_sorted = slice_sorted};
+		collect_tasks(tasks, &count, &root, 0, split_depth, depth1);
+		for (int i = 0; i < thread_count; ++i) {
+			pool.deques[i].tasks = tasks;
+			pool.deques[i].top = count * i / thread_count;
+			pool.deques[i].bottom = count * (i + 1) / thread_count;
+		}
+		pool.depth1 = depth1;
+		pool.split_depth = split_depth;
+
+		pthread_barrier_wait(&pool.start_barrier);
+		run_tasks(&pool, 0);
+		pthread_barrier_wait(&pool.end_barrier);
+	}
+	atomic_fetch_add(&shared->nodes, search.nodes);
+
+	pool.done = true;
+	pthread_barrier_wait(&pool.start_barrier);
+	for (int i = 1; i < thread_count; ++i) pthread_join(workers[i].thread, NULL);
+
+	pthread_barrier_destroy(&pool.start_barrier);
+	pthread_barrier_destroy(&pool.end_barrier);
+	pthread_mutex_destroy(&pool.start_lock);
+	for (int i = 0; i < pool_size; ++i) pthread_mutex_destroy(&pool.deques[i].lock);
+	free(tasks);
+	free(pool.deques);
+	free(workers);
+	return true;
+}
+
+enum cubie_error solve_cubie(const struct cubie_cube *cube, const struct solve_options *options, struct solution *solution) {
+	if (options->optimal) return solve_optimal(cube, options, solution);
+	enum cubie_error error = verify_cubie(cube);
+	if (error != CUBIE_OK) return error;
+	init_solver();
+
+	struct search_shared shared = {
+	        .cube = *cube,
+	        .options = options,
+	        .target_length = options->target_length,
+	        .start_time = get_time_ns(),
+	        .solution = solution,
+	};
+	atomic_init(&shared.best_length, MAX_SOLUTION_LENGTH + 1);
+	atomic_init(&shared.stop, false);
+	atomic_init(&shared.nodes, 0);
+	pthread_mutex_init(&shared.solution_lock, NULL);
+	shared.deadline = options->time_limit_ns ? shared.start_time + options->time_limit_ns : 0;
+	solution->length = 0;
+
+	uint16_t twist = get_twist(cube), flip = get_flip(cube), slice_sorted = get_slice_sorted(cube);
+	int min_depth1 = get_phase1_distance(twist, flip, slice_sorted / 24);
+	if (options->threads <= 1 || !solve_parallel(&shared, options->threads, twist, flip, slice_sorted, min_depth1)) {
+		struct search search = {.shared = &shared, .nodes = 0};
+		for (int depth1 = min_depth1; depth1 < atomic_load(&shared.best_length) && !atomic_load(&shared.stop); ++depth1) {
+			search_phase1(&search, twist, flip, slice_sorted, 0, depth1);
+		}
+		atomic_fetch_add(&shared.nodes, search.nodes);
+	}
+
+	solution->nodes = atomic_load(&shared.nodes);
+	pthread_mutex_destroy(&shared.solution_lock);
+	return CUBIE_OK;
+}
+
+enum cubie_error solve_cube(const struct cube *cube, const struct solve_options *options, struct solution *solution) {
+	struct cubie_cube cubie;
+	enum cubie_error error = cube_to_cubie(cube, &cubie);
+	if (error != CUBIE_OK) return error;
+	return solve_cubie(&cubie, options, solution);
+}
+
+struct solve_job {
+	struct cubie_cube cube;
+	struct solve_options options;
+	struct solve_options caller_options; // for the caller's on_solution
+	enum cubie_error error;
+	struct solution result;
+
+	pthread_t thread;
+	bool started;
+	pthread_mutex_t lock;
+	struct solution best; // copy of the latest solution, guarded by lock
+	bool found;
+	atomic_bool done, cancel;
+};
+
+static void save_job_solution(const struct solution *solution, void *userdata) {
+	struct solve_job *job = userdata;
+	pthread_mutex_lock(&job->lock);
+	job->best = *solution;
+	job->found = true;
+	pthread_mutex_unlock(&job->lock);
+	if (job->caller_options.on_solution) job->caller_options.on_solution(solution, job->caller_options.userdata);
+}
+
+static void *solve_job_thread(void *data) {
+	struct solve_job *job = data;
+	job->error = solve_cubie(&job->cube, &job->options, &job->result);
+	atomic_store(&job->done, true);
+	return NULL;
+}
+
+struct solve_job *start_solve_job(const struct cube *cube, const struct solve_options *options) {
+	struct solve_job *job = calloc(1, sizeof(struct solve_job));
+	if (!job) {
+		warn("Failed to allocate solve job");
+		return NULL;
+	}
+	job->options = job->caller_options = *options;
+	job->options.on_solution = save_job_solution;
+	job->options.userdata = job;
+	job->options.cancel = &job->cancel;
+	job->found = false;
+	atomic_init(&job->done, false);
+	atomic_init(&job->cancel, false);
+	pthread_mutex_init(&job->lock, NULL);
+
+	// a cube that cannot be solved finishes straight away
+	job->error = cube_to_cubie(cube, &job->cube);
+	if (job->error != CUBIE_OK) {
+		atomic_store(&job->done, true);
+		return job;
+	}
+
+	// the tables are loaded here so the thread never builds them while another one uses them
+	if (options->optimal) init_optimal_solver(options);
+	else init_solver();
+	if (pthread_create(&job->thread, NULL, solve_job_thread, job) != 0) {
+		warnx("Failed to start solver thread");
+		pthread_mutex_destroy(&job->lock);
+		free(job);
+		return NULL;
+	}
+	job->started = true;
+	return job;
+}
+
+bool poll_solve_job(struct solve_job *job, struct solution *solution) {
+	// copies the best solution found so far, returns false if there is none yet
+	pthread_mutex_lock(&job->lock);
+	bool found = job->found;
+	if (found) *solution = job->best;
+	pthread_mutex_unlock(&job->lock);
+	return found;
+}
+
+bool is_solve_job_done(struct solve_job *job) {
+	return atomic_load(&job->done);
+}
+
+enum cubie_error get_solve_job_error(struct solve_job *job) {
+	// only valid once the job is done
+	return job->error;
+}
+
+void cancel_solve_job(struct solve_job *job) {
+	atomic_store(&job->cancel, true);
+}
+
+void free_solve_job(struct solve_job *job) {
+	if (!job) return;
+	cancel_solve_job(job);
+	if (job->started) pthread_join(job->thread, NULL);
+	pthread_mutex_destroy(&job->lock);
+	free(job);
+}
@@ -0,0 +1,49 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "cubie.h"
+#include "transposition.h"
+
+// longest solution the two-phase search can return, phase 2 takes at most PHASE2_MAX_DEPTH (10) moves of it
+#define MAX_SOLUTION_LENGTH 30
+
+struct solution;
+
+struct solve_options {
+	int target_length;      // stop as soon as a solution this short is found
+	uint64_t time_limit_ns; // stop looking for shorter solutions after this long, 0 for no limit
+	int threads;            // number of threads searching at once, defaults to the number of cpus
+	bool optimal;           // find a shortest solution with the optimal solver instead, ignoring the options above
+	int pattern_edges;      // edges in each edge pattern database of the optimal solver
+	int transposition_mb;   // size of the table of distance bounds the optimal solver keeps between solves, 0 for none
+	enum replacement_policy replacement;
+
+	// called with every solution shorter than the ones before, from whichever thread found it, may be NULL
+	void (*on_solution)(const struct solution *solution, void *userdata);
+	void *userdata;
+	atomic_bool *cancel; // the search stops early once this is true, possibly without a solution, may be NULL
+};
+
+struct solution {
+	struct move moves[MAX_SOLUTION_LENGTH];
+	size_t length;
+	uint64_t time_ns; // time taken to find this solution
+	uint64_t nodes;   // number of search nodes visited
+};
+
+void init_solver();
+struct solve_options get_default_solve_options();
+enum cubie_error solve_cube(const struct cube *cube, const struct solve_options *options, struct solution *solution);
+enum cubie_error solve_cubie(const struct cubie_cube *cube, const struct solve_options *options, struct solution *solution);
+
+// a solve running on its own thread, so the best solution so far can be used while it keeps searching
+struct solve_job;
+struct solve_job *start_solve_job(const struct cube *cube, const struct solve_options *options);
+bool poll_solve_job(struct solve_job *job, struct solution *solution);
+bool is_solve_job_done(struct solve_job *job);
+enum cubie_error get_solve_job_error(struct solve_job *job);
+void cancel_solve_job(struct solve_job *job);
+void free_solve_job(struct solve_job *job);
+#endif //SOLVER_H
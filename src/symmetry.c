@@ -0,0 +1,204 @@
+#include <string.h>
+#include "symmetry.h"
+#include "coord.h"
+#include "err.h"
+
+struct symmetry {
+	struct permutation permutation; // where the stickers move, like a move
+	face_color colors[6];           // recolors the moved stickers so each center has the color of its face again, also where each face goes
+};
+
+static struct symmetry symmetries[SYMMETRY_COUNT];
+static int inverse_symmetries[SYMMETRY_COUNT];
+static bool symmetry_init = false;
+
+// faces around each corner position, in the order of enum corner
+static const intpos corner_faces[8][3] = {
+        {0, 2, 1},
+        {0, 1, 4},
+        {0, 4, 3},
+        {0, 3, 2},
+        {5, 1, 2},
+        {5, 4, 1},
+        {5, 3, 4},
+        {5, 2, 3},
+};
+// where each symmetry takes each corner position
+static intpos corner_symmetries[SYMMETRY_COUNT][8];
+
+static uint16_t corners_classes[CORNERS_COUNT];
+static uint8_t corners_class_symmetries[CORNERS_COUNT]; // symmetry that takes the representative to the permutation
+static uint16_t corners_representatives[CORNERS_CLASS_COUNT];
+
+static void get_mirror_permutation(struct permutation *permutation) {
+	// reflects the cube through the plane between L and R, which swaps those faces and reverses every row
+	for (intpos face = 0; face < 6; ++face) {
+		intpos mirrored = face == 2 ? 4 : face == 4 ? 2 : face;
+		for (intpos row = 0; row < 3; ++row) {
+			for (intpos column = 0; column < 3; ++column) {
+				permutation->stickers[mirrored * 9 + row * 3 + 2 - column] = face * 9 + row * 3 + column;
+			}
+		}
+	}
+}
+
+static void init_symmetry_colors(struct symmetry *symmetry) {
+	// the center of face k moves to face colors[k]
+	for (intpos face = 0; face < 6; ++face) {
+		symmetry->colors[symmetry->permutation.stickers[face * 9 + 4] / 9] = face;
+	}
+}
+
+static int find_rotation(const struct permutation *permutation, int count) {
+	for (int i = 0; i < count; ++i) {
+		if (memcmp(&symmetries[i].permutation, permutation, sizeof(struct permutation)) == 0) return i;
+	}
+	return -1;
+}
+
+static void init_corner_symmetries() {
+	for (int symmetry = 0; symmetry < SYMMETRY_COUNT; ++symmetry) {
+		for (intpos corner = 0; corner < 8; ++corner) {
+			// the corner between faces a, b and c moves to the one between the faces they move to
+			const face_color *colors = symmetries[symmetry].colors;
+			int mask = 1 << colors[corner_faces[corner][0]] | 1 << colors[corner_faces[corner][1]] | 1 << colors[corner_faces[corner][2]];
+			for (intpos other = 0; other < 8; ++other) {
+				if ((1 << corner_faces[other][0] | 1 << corner_faces[other][1] | 1 << corner_faces[other][2]) == mask) {
+					corner_symmetries[symmetry][corner] = other;
+				}
+			}
+		}
+	}
+}
+
+static void init_corners_classes() {
+	memset(corners_classes, 0xff, sizeof(corners_classes));
+	uint16_t count = 0;
+	for (uint32_t corners = 0; corners < CORNERS_COUNT; ++corners) {
+		if (corners_classes[corners] != 0xffff) continue;
+		// counting up, so the first permutation of each class is the smallest and becomes its representative
+		if (count == CORNERS_CLASS_COUNT) errx(1, "Too many corner permutation classes");
+		corners_representatives[count] = corners;
+		for (int symmetry = 0; symmetry < SYMMETRY_COUNT; ++symmetry) {
+			uint16_t symmetric = get_symmetric_corners(corners, symmetry);
+			if (corners_classes[symmetric] != 0xffff) continue;
+			corners_classes[symmetric] = count;
+			corners_class_symmetries[symmetric] = symmetry;
+		}
+		++count;
+	}
+	if (count != CORNERS_CLASS_COUNT) errx(1, "Found %d corner permutation classes instead of %d", count, CORNERS_CLASS_COUNT);
+}
+
+void init_symmetry() {
+	if (symmetry_init) return;
+	symmetry_init = true;
+	init_move_tables();
+
+	// every rotation is a product of x and y
+	reset_permutation(&symmetries[0].permutation);
+	const struct permutation *generators[] = {get_move_permutation((struct move){x, cw}), get_move_permutation((struct move){y, cw})};
+	int count = 1;
+	for (int i = 0; i < count; ++i) {
+		for (int j = 0; j < 2; ++j) {
+			struct permutation product;
+			compose_permutation(&product, &symmetries[i].permutation, generators[j]);
+			if (find_rotation(&product, count) >= 0) continue;
+			symmetries[count++].permutation = product;
+		}
+	}
+	if (count != ROTATION_COUNT) errx(1, "Found %d rotations instead of %d", count, ROTATION_COUNT);
+
+	// then the same rotations after a mirror
+	struct permutation mirror;
+	get_mirror_permutation(&mirror);
+	for (int i = 0; i < ROTATION_COUNT; ++i) {
+		compose_permutation(&symmetries[ROTATION_COUNT + i].permutation, &mirror, &symmetries[i].permutation);
+	}
+
+	for (int i = 0; i < SYMMETRY_COUNT; ++i) init_symmetry_colors(&symmetries[i]);
+	for (int i = 0; i < SYMMETRY_COUNT; ++i) {
+		struct permutation inverse;
+		invert_permutation(&inverse, &symmetries[i].permutation);
+		inverse_symmetries[i] = -1;
+		for (int j = 0; j < SYMMETRY_COUNT; ++j) {
+			if (memcmp(&symmetries[j].permutation, &inverse, sizeof(struct permutation)) == 0) inverse_symmetries[i] = j;
+		}
+	}
+
+	init_corner_symmetries();
+	init_corners_classes();
+}
+
+static void normalize_colors(const struct cube *cube, struct cube *result) {
+	// recolors the cube so the center of each face has the color of that face, like cube_to_cubie does
+	face_color colors[256];
+	memset(colors, 0, sizeof(colors));
+	for (intpos face = 0; face < 6; ++face) colors[cube->faces[face].stickers[4]] = face;
+	for (intpos i = 0; i < 9 * 6; ++i) result->stickers[i] = colors[cube->stickers[i]];
+}
+
+void apply_symmetry(const struct cube *cube, int symmetry, struct cube *result) {
+	// the cube seen through the symmetry, recolored to the usual colors
+	init_symmetry();
+	struct cube normalized;
+	normalize_colors(cube, &normalized);
+	const struct symmetry *current = &symmetries[symmetry];
+	for (intpos i = 0; i < 9 * 6; ++i) {
+		result->stickers[i] = current->colors[normalized.stickers[current->permutation.stickers[i]]];
+	}
+}
+
+int get_inverse_symmetry(int symmetry) {
+	init_symmetry();
+	return inverse_symmetries[symmetry];
+}
+
+int get_canonical_cube(const struct cube *cube, struct cube *canonical) {
+	// the smallest sticker array any symmetry turns the cube into, returns that symmetry
+	init_symmetry();
+	struct cube normalized;
+	normalize_colors(cube, &normalized);
+	*canonical = normalized;
+
+	int best = 0;
+	for (int symmetry = 1; symmetry < SYMMETRY_COUNT; ++symmetry) {
+		const struct symmetry *current = &symmetries[symmetry];
+		// most symmetries are worse within the first few stickers, so only finish the ones that are better
+		intpos i = 0;
+		face_color color = 0;
+		for (; i < 9 * 6; ++i) {
+			color = current->colors[normalized.stickers[current->permutation.stickers[i]]];
+			if (color != canonical->stickers[i]) break;
+		}
+		if (i == 9 * 6 || color > canonical->stickers[i]) continue;
+
+		for (; i < 9 * 6; ++i) {
+			canonical->stickers[i] = current->colors[normalized.stickers[current->permutation.stickers[i]]];
+		}
+		best = symmetry;
+	}
+	return best;
+}
+
+uint16_t get_symmetric_corners(uint16_t corners, int symmetry) {
+	// the piece in each position moves to where the symmetry takes that position, and becomes the piece of where it takes the piece
+	init_symmetry();
+	uint8_t permutation[8], result[8];
+	set_permutation_rank(permutation, 8, corners);
+	const intpos *map = corner_symmetries[symmetry];
+	for (intpos i = 0; i < 8; ++i) result[map[i]] = map[permutation[i]];
+	return get_permutation_rank(result, 8);
+}
+
+uint16_t get_corners_class(uint16_t corners, int *symmetry) {
+	// symmetry takes the representative of the class to corners
+	init_symmetry();
+	if (symmetry) *symmetry = corners_class_symmetries[corners];
+	return corners_classes[corners];
+}
+
+uint16_t get_corners_representative(uint16_t corners_class) {
+	init_symmetry();
+	return corners_representatives[corners_class];
+}
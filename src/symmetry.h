@@ -0,0 +1,21 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+#include <stdint.h>
+#include "rubik.h"
+
+// the 48 symmetries of the cube, 24 rotations and the same rotations after a left to right mirror
+// symmetry 0 is the identity and symmetries 24 to 47 are mirrored
+#define SYMMETRY_COUNT 48
+#define ROTATION_COUNT 24
+
+// corner permutations that are the same under some symmetry share a class
+#define CORNERS_CLASS_COUNT 984
+
+void init_symmetry();
+void apply_symmetry(const struct cube *cube, int symmetry, struct cube *result);
+int get_inverse_symmetry(int symmetry);
+int get_canonical_cube(const struct cube *cube, struct cube *canonical);
+uint16_t get_corners_class(uint16_t corners, int *symmetry);
+uint16_t get_corners_representative(uint16_t corners_class);
+uint16_t get_symmetric_corners(uint16_t corners, int symmetry);
+#endif //SYMMETRY_H
@@ -0,0 +1,203 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "table_file.h"
+#include "err.h"
+#include "util.h"
+
+#define TABLE_FILE_MAGIC "RUBIKTBL"
+#define TABLE_FILE_VERSION 1
+// the tables start on their own page
+#define TABLE_FILE_HEADER_SIZE 4096
+
+struct table_file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t key;
+	uint64_t size;
+	uint64_t checksum;
+};
+
+uint64_t hash_table_data(const void *data, size_t size, uint64_t seed) {
+	// fast 64 bit hash over whole words, only used to detect corrupt or truncated files
+	const uint8_t *bytes = data;
+	uint64_t hash = seed ^ (size * 0x9e3779b97f4a7c15ull);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+		hash ^= hash >> 29;
+	}
+	for (; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static bool make_dirs(char *path) {
+	// like mkdir -p, path is modified temporarily
+	for (char *c = path + 1;; ++c) {
+		if (*c != '/' && *c != '\0') continue;
+		char end = *c;
+		*c = '\0';
+		bool ok = mkdir(path, 0755) == 0 || errno == EEXIST;
+		*c = end;
+		if (!ok || !end) return ok;
+	}
+}
+
+static bool get_table_dir(char *path, size_t size) {
+	const char *dir = getenv("RUBIK_TABLE_DIR");
+	const char *cache = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	int length;
+	if (dir && *dir) {
+		length = snprintf(path, size, "%s", dir);
+	} else if (cache && *cache) {
+		length = snprintf(path, size, "%s/%s", cache, TARGET);
+	} else if (home && *home) {
+		length = snprintf(path, size, "%s/.cache/%s", home, TARGET);
+	} else {
+		return false;
+	}
+	if (length < 0 || (size_t) length >= size) return false;
+	return make_dirs(path);
+}
+
+static bool map_file(const char *path, uint64_t key, size_t size, struct table_file *file) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	size_t mapping_size = TABLE_FILE_HEADER_SIZE + size;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size != mapping_size) {
+		close(fd);
+		return false;
+	}
+
+	void *mapping = mmap(NULL, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	const struct table_file_header *header = mapping;
+	const void *data = (const uint8_t *) mapping + TABLE_FILE_HEADER_SIZE;
+	if (memcmp(header->magic, TABLE_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+	    header->version != TABLE_FILE_VERSION ||
+	    header->header_size != TABLE_FILE_HEADER_SIZE ||
+	    header->key != key ||
+	    header->size != size ||
+	    header->checksum != hash_table_data(data, size, key)) {
+		munmap(mapping, mapping_size);
+		return false;
+	}
+
+	file->data = data;
+	file->size = size;
+	file->mapping = mapping;
+	file->mapping_size = mapping_size;
+	return true;
+}
+
+static bool write_file(const char *path, uint64_t key, size_t size, table_builder build, void *userdata) {
+	// build into a temporary file and rename it so other processes never see a partial file
+	char temp_path[4096];
+	if ((size_t) snprintf(temp_path, sizeof(temp_path), "%s.%ld.tmp", path, (long) getpid()) >= sizeof(temp_path)) return false;
+
+	int fd = open(temp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		warn("Failed to create %s", temp_path);
+		return false;
+	}
+
+	size_t mapping_size = TABLE_FILE_HEADER_SIZE + size;
+	void *mapping = MAP_FAILED;
+	if (ftruncate(fd, mapping_size) == 0) {
+		mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		warn("Failed to map %s", temp_path);
+		unlink(temp_path);
+		return false;
+	}
+
+	void *data = (uint8_t *) mapping + TABLE_FILE_HEADER_SIZE;
+	bool ok = build(data, size, userdata);
+	if (ok) {
+		struct table_file_header *header = mapping;
+		memcpy(header->magic, TABLE_FILE_MAGIC, sizeof(header->magic));
+		header->version = TABLE_FILE_VERSION;
+		header->header_size = TABLE_FILE_HEADER_SIZE;
+		header->key = key;
+		header->size = size;
+		header->checksum = hash_table_data(data, size, key);
+		if (msync(mapping, mapping_size, MS_SYNC) != 0) ok = false;
+	}
+	munmap(mapping, mapping_size);
+
+	if (ok && rename(temp_path, path) != 0) {
+		warn("Failed to rename %s", temp_path);
+		ok = false;
+	}
+	if (!ok) unlink(temp_path);
+	return ok;
+}
+
+bool load_table_file(const char *name, uint64_t key, size_t size, table_builder build, void *userdata, struct table_file *file) {
+	uint64_t start = get_time_ns();
+	char path[4096];
+	bool have_dir = get_table_dir(path, sizeof(path) - strlen(name) - 64);
+	if (have_dir) {
+		strcat(path, "/");
+		strcat(path, name);
+
+		if (map_file(path, key, size, file)) {
+			fprintf(stderr, "Mapped %s: %.2f MiB in %.1f ms\n", path, size / 1048576.0, (get_time_ns() - start) / 1e6);
+			return true;
+		}
+
+		// missing, corrupt or built from different tables
+		if (write_file(path, key, size, build, userdata) && map_file(path, key, size, file)) {
+			fprintf(stderr, "Built %s: %.2f MiB in %.1f ms\n", path, size / 1048576.0, (get_time_ns() - start) / 1e6);
+			return true;
+		}
+		warnx("Failed to save %s, keeping tables in memory", path);
+	} else {
+		warnx("No cache directory for %s, keeping tables in memory", name);
+	}
+
+	void *data = malloc(size);
+	if (!data) {
+		warn("Failed to allocate %s", name);
+		return false;
+	}
+	if (!build(data, size, userdata)) {
+		free(data);
+		return false;
+	}
+	file->data = data;
+	file->size = size;
+	file->mapping = NULL;
+	file->mapping_size = 0;
+	fprintf(stderr, "Built %s in memory: %.2f MiB in %.1f ms\n", name, size / 1048576.0, (get_time_ns() - start) / 1e6);
+	return true;
+}
+
+void unload_table_file(struct table_file *file) {
+	if (file->mapping) {
+		munmap(file->mapping, file->mapping_size);
+	} else {
+		free((void *) file->data);
+	}
+	file->data = NULL;
+	file->mapping = NULL;
+	file->size = 0;
+	file->mapping_size = 0;
+}
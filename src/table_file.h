@@ -0,0 +1,24 @@
+#ifndef TABLE_FILE_H
+#define TABLE_FILE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// precomputed tables stored in a file in the cache directory and mapped read only
+// several processes using the same file share its pages through the page cache
+struct table_file {
+	const void *data; // the tables, after the header
+	size_t size;      // size of the tables without the header
+	void *mapping;    // whole mapping including the header, NULL when the tables are in memory instead
+	size_t mapping_size;
+};
+
+// fills data with the tables, returns false on failure
+typedef bool (*table_builder)(void *data, size_t size, void *userdata);
+
+// maps the tables from name, or builds them with build and writes the file first if it is missing or stale
+// key should change whenever the contents of the tables would change
+bool load_table_file(const char *name, uint64_t key, size_t size, table_builder build, void *userdata, struct table_file *file);
+void unload_table_file(struct table_file *file);
+uint64_t hash_table_data(const void *data, size_t size, uint64_t seed);
+#endif //TABLE_FILE_H
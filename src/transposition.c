@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <string.h>
+#include "transposition.h"
+#include "err.h"
+
+// data of an entry, an all zero entry is empty
+#define DATA_VALUE(data_) ((uint32_t) (data_))
+#define DATA_DEPTH(data_) ((uint8_t) ((data_) >> 32))
+#define DATA_GENERATION(data_) ((uint8_t) ((data_) >> 40))
+#define DATA_TAG(data_) ((data_) >> 48 & 0x7fff) // more bits of the hash than the bucket index uses
+#define DATA_VALID (1ull << 63)
+
+static const char *const policy_names[REPLACEMENT_POLICY_COUNT] = {
+        [REPLACE_ALWAYS] = "always",
+        [REPLACE_DEPTH] = "depth",
+        [REPLACE_AGE] = "age",
+};
+
+bool parse_replacement_policy(const char *text, enum replacement_policy *policy) {
+	for (enum replacement_policy i = 0; i < REPLACEMENT_POLICY_COUNT; ++i) {
+		if (strcmp(text, policy_names[i]) == 0) {
+			*policy = i;
+			return true;
+		}
+	}
+	warnx("Invalid replacement policy: %s, expected always, depth or age", text);
+	return false;
+}
+
+bool init_transposition_table(struct transposition_table *table, size_t megabytes, enum replacement_policy policy) {
+	// the largest power of two number of buckets that fits
+	size_t bucket_size = TRANSPOSITION_BUCKET_SIZE * sizeof(struct transposition_entry);
+	size_t bucket_count = 1;
+	while (bucket_count * 2 * bucket_size <= megabytes << 20) bucket_count *= 2;
+
+	table->entries = aligned_alloc(bucket_size, bucket_count * bucket_size);
+	if (!table->entries) {
+		warn("Failed to allocate transposition table");
+		return false;
+	}
+	table->bucket_mask = bucket_count - 1;
+	table->policy = policy;
+	clear_transposition_table(table);
+	return true;
+}
+
+void free_transposition_table(struct transposition_table *table) {
+	free(table->entries);
+	table->entries = NULL;
+}
+
+void clear_transposition_table(struct transposition_table *table) {
+	memset(table->entries, 0, (table->bucket_mask + 1) * TRANSPOSITION_BUCKET_SIZE * sizeof(struct transposition_entry));
+	atomic_store(&table->generation, 0);
+}
+
+void next_transposition_generation(struct transposition_table *table) {
+	// entries from earlier generations are replaced first by REPLACE_AGE
+	atomic_fetch_add(&table->generation, 1);
+}
+
+static struct transposition_entry *get_bucket(struct transposition_table *table, struct cube_hash hash) {
+	return &table->entries[(hash.low & table->bucket_mask) * TRANSPOSITION_BUCKET_SIZE];
+}
+
+static bool is_entry_for(uint64_t check, uint64_t data, struct cube_hash hash) {
+	return (data & DATA_VALID) && (check ^ data) == hash.high && DATA_TAG(data) == (hash.low >> 48 & 0x7fff);
+}
+
+bool probe_transposition(struct transposition_table *table, struct cube_hash hash, uint32_t *value, uint8_t *depth) {
+	struct transposition_entry *bucket = get_bucket(table, hash);
+	for (int i = 0; i < TRANSPOSITION_BUCKET_SIZE; ++i) {
+		uint64_t data = atomic_load_explicit(&bucket[i].data, memory_order_relaxed);
+		uint64_t check = atomic_load_explicit(&bucket[i].check, memory_order_relaxed);
+		if (!is_entry_for(check, data, hash)) continue;
+		*value = DATA_VALUE(data);
+		*depth = DATA_DEPTH(data);
+		return true;
+	}
+	return false;
+}
+
+void store_transposition(struct transposition_table *table, struct cube_hash hash, uint32_t value, uint8_t depth) {
+	uint8_t generation = atomic_load_explicit(&table->generation, memory_order_relaxed);
+	uint64_t new_data = DATA_VALID | (hash.low >> 48 & 0x7fff) << 48 | (uint64_t) generation << 40 | (uint64_t) depth << 32 | value;
+
+	struct transposition_entry *bucket = get_bucket(table, hash);
+	int victim = -1, victim_age = -1, victim_depth = 256;
+	for (int i = 0; i < TRANSPOSITION_BUCKET_SIZE; ++i) {
+		uint64_t data = atomic_load_explicit(&bucket[i].data, memory_order_relaxed);
+		uint64_t check = atomic_load_explicit(&bucket[i].check, memory_order_relaxed);
+		// the same hash or an empty entry is always used
+		if (!(data & DATA_VALID) || is_entry_for(check, data, hash)) {
+			victim = i;
+			victim_depth = -1;
+			break;
+		}
+
+		int age = (uint8_t) (generation - DATA_GENERATION(data)), entry_depth = DATA_DEPTH(data);
+		switch (table->policy) {
+			case REPLACE_ALWAYS:
+				break;
+			case REPLACE_DEPTH:
+				if (entry_depth >= victim_depth) break;
+				victim = i;
+				victim_depth = entry_depth;
+				break;
+			case REPLACE_AGE:
+				if (age < victim_age || (age == victim_age && entry_depth >= victim_depth)) break;
+				victim = i;
+				victim_age = age;
+				victim_depth = entry_depth;
+				break;
+			default:
+				break;
+		}
+	}
+	if (victim < 0) {
+		// REPLACE_ALWAYS spreads hashes that share a bucket over its entries
+		victim = hash.high % TRANSPOSITION_BUCKET_SIZE;
+	} else if (table->policy == REPLACE_DEPTH && depth < victim_depth) {
+		// every entry in the bucket is worth more than this one
+		return;
+	}
+
+	atomic_store_explicit(&bucket[victim].data, new_data, memory_order_relaxed);
+	atomic_store_explicit(&bucket[victim].check, hash.high ^ new_data, memory_order_relaxed);
+}
@@ -0,0 +1,39 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+#include <stdatomic.h>
+#include <stddef.h>
+#include "hash.h"
+
+// fixed size table of cube hashes and a value for each, safe to use from several threads without locks
+// an entry can be lost to a concurrent write, but a probe never returns a value stored for a different hash
+
+// which entry of a full bucket a new entry replaces
+enum replacement_policy {
+	REPLACE_ALWAYS, // an entry chosen by the hash
+	REPLACE_DEPTH,  // the entry with the lowest depth, unless the new one is even lower
+	REPLACE_AGE,    // the entry from the oldest generation, then the lowest depth
+	REPLACEMENT_POLICY_COUNT,
+};
+
+struct transposition_entry {
+	_Atomic uint64_t check; // high half of the hash xor data, detects torn writes
+	_Atomic uint64_t data;
+};
+
+struct transposition_table {
+	struct transposition_entry *entries; // buckets of TRANSPOSITION_BUCKET_SIZE entries, one cache line each
+	size_t bucket_mask;
+	enum replacement_policy policy;
+	atomic_uint generation;
+};
+
+#define TRANSPOSITION_BUCKET_SIZE 4
+
+bool init_transposition_table(struct transposition_table *table, size_t megabytes, enum replacement_policy policy);
+void free_transposition_table(struct transposition_table *table);
+void clear_transposition_table(struct transposition_table *table);
+void next_transposition_generation(struct transposition_table *table);
+bool probe_transposition(struct transposition_table *table, struct cube_hash hash, uint32_t *value, uint8_t *depth);
+void store_transposition(struct transposition_table *table, struct cube_hash hash, uint32_t value, uint8_t depth);
+bool parse_replacement_policy(const char *text, enum replacement_policy *policy);
+#endif //TRANSPOSITION_H
@@ -1,4 +1,6 @@
 #include "util.h"
+#include <time.h>
+#include <unistd.h>
 
 struct vec3 vec3(float x, float y, float z) {
 	return (struct vec3){{{x, y, z}}};
@@ -18,3 +20,15 @@ struct rect rect(struct vec3 a, struct vec3 b, struct vec3 c, struct vec3 d) {
 struct rect rect4(struct vec3 a) {
 	return rect(a, a, a, a);
 }
+
+uint64_t get_time_ns() {
+	// monotonic clock that works without SDL
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int get_cpu_count() {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? count : 1;
+}
@@ -1,5 +1,6 @@
 #ifndef UTIL_H
 #define UTIL_H
+#include <stdint.h>
 struct tri {
 	struct vec3 {
 		union {
@@ -19,4 +20,6 @@ struct vec3 vec3(float x, float y, float z);
 struct tri tri(struct vec3 a, struct vec3 b, struct vec3 c);
 struct rect rect(struct vec3 a, struct vec3 b, struct vec3 c, struct vec3 d);
 struct rect rect4(struct vec3 a);
+uint64_t get_time_ns();
+int get_cpu_count();
 #endif